@@ -0,0 +1,9 @@
+#pragma once
+
+// stand-in for libDaisy's daisy_core.h on the host
+// only what the library itself uses
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "daisy_core.h"
+
+namespace daisy
+{
+// stand-in for libDaisy's UartHandler on the host
+// transmitting only counts the bytes, one DMA transfer at a time
+class UartHandler
+{
+  public:
+    enum class Result
+    {
+        OK,
+        ERR
+    };
+
+    typedef void (*StartCallbackFunctionPtr)(void *context);
+    typedef void (*EndCallbackFunctionPtr)(void *context, Result result);
+
+    Result BlockingTransmit(uint8_t *buff, size_t size, uint32_t timeout = 100)
+    {
+        (void)timeout;
+        // read the bytes so the copy into the transmit buffer is not elided
+        for(size_t i = 0; i < size; i++)
+        {
+            checksum += buff[i];
+        }
+        bytesSent += size;
+        transmits++;
+        return Result::OK;
+    }
+
+    // like libDaisy, a transfer completes later, in the interrupt, which
+    // completeTransfer() stands in for, a refused transfer doesn't call
+    // back at all
+    Result DmaTransmit(uint8_t                 *buff,
+                       size_t                   size,
+                       StartCallbackFunctionPtr start_callback,
+                       EndCallbackFunctionPtr   end_callback,
+                       void                    *callback_context)
+    {
+        if(dmaSize > 0 || refuseTransfers > 0)
+        {
+            if(refuseTransfers > 0)
+            {
+                refuseTransfers--;
+            }
+            return Result::ERR;
+        }
+        if(start_callback)
+        {
+            start_callback(callback_context);
+        }
+        dmaBuffer   = buff;
+        dmaSize     = size;
+        dmaCallback = end_callback;
+        dmaContext  = callback_context;
+        return Result::OK;
+    }
+
+    // finishes the transfer in flight and calls its end callback, which
+    // reports ERR if failTransfers is set
+    // returns false if there was none
+    bool completeTransfer()
+    {
+        if(dmaSize == 0)
+        {
+            return false;
+        }
+        Result result = Result::OK;
+        if(failTransfers > 0)
+        {
+            failTransfers--;
+            result = Result::ERR;
+        }
+        else
+        {
+            BlockingTransmit(dmaBuffer, dmaSize);
+        }
+        EndCallbackFunctionPtr callback = dmaCallback;
+        dmaSize                         = 0;
+        if(callback)
+        {
+            callback(dmaContext, result);
+        }
+        return true;
+    }
+
+    // whether a DMA transfer is in flight
+    bool isTransferring() { return dmaSize > 0; }
+
+    // the number of coming transfers to refuse, or to fail on completion
+    int refuseTransfers = 0;
+    int failTransfers   = 0;
+
+    uint64_t bytesSent = 0;
+    uint64_t transmits = 0;
+    uint32_t checksum  = 0;
+
+  private:
+    // the transfer in flight
+    uint8_t               *dmaBuffer   = NULL;
+    size_t                 dmaSize     = 0;
+    EndCallbackFunctionPtr dmaCallback = NULL;
+    void                  *dmaContext  = NULL;
+};
+} // namespace daisy
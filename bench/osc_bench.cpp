@@ -0,0 +1,414 @@
+// host benchmark of the hot paths of the library
+//
+// every case runs over the same mix of messages, a handful of control-rate
+// messages of the kind a synth receives, and reports the throughput and the
+// time per message, see the Makefile for building it
+
+#include <chrono>
+#include <stdio.h>
+
+#include "OSCCoalescer.h"
+#include "OSCMessage.h"
+#include "OSCMessageView.h"
+#include "OSCMatch.h"
+#include "OSCRouter.h"
+#include "OSCSchema.h"
+
+/*=============================================================================
+    HARNESS
+ =============================================================================*/
+
+// results are accumulated here so that the work can't be optimized away
+static volatile uint32_t sink;
+
+// the minimum time spent in each case
+static const double minSeconds = 0.2;
+
+// calls fn until minSeconds have passed
+// fn handles itemsPerCall messages per call
+template <typename F>
+static void bench(const char *name, int itemsPerCall, F fn)
+{
+    typedef std::chrono::steady_clock clock;
+
+    // warm up the caches and branch predictors
+    for(int i = 0; i < 10; i++)
+    {
+        fn();
+    }
+
+    // the batches grow until the clock's resolution doesn't matter
+    uint64_t calls   = 0;
+    double   elapsed = 0;
+    uint64_t batch   = 1;
+    while(elapsed < minSeconds)
+    {
+        clock::time_point start = clock::now();
+        for(uint64_t i = 0; i < batch; i++)
+        {
+            fn();
+        }
+        elapsed += std::chrono::duration<double>(clock::now() - start).count();
+        calls += batch;
+        batch *= 2;
+    }
+    double items = (double)calls * itemsPerCall;
+    printf("%-36s %12.0f msg/s %10.1f ns/msg\n",
+           name,
+           items / elapsed,
+           elapsed * 1e9 / items);
+}
+
+/*=============================================================================
+    MESSAGES
+ =============================================================================*/
+
+#define MIX_SIZE 6
+
+static OSCMessage *mix[MIX_SIZE];
+
+// the encoded messages
+static uint8_t packets[MIX_SIZE][256];
+static int     packetLengths[MIX_SIZE];
+
+static void buildMix()
+{
+    static uint8_t blob[64];
+    for(int i = 0; i < 64; i++)
+    {
+        blob[i] = i;
+    }
+    mix[0] = new OSCMessage("/synth/voice/3/freq");
+    mix[0]->add(440.0f);
+    mix[1] = new OSCMessage("/mixer/ch/12/gain");
+    mix[1]->add(0.75f);
+    mix[2] = new OSCMessage("/seq/step");
+    mix[2]->add(7).add(127);
+    mix[3] = new OSCMessage("/patch/name");
+    mix[3]->add("warm pad");
+    mix[4] = new OSCMessage("/sample/data");
+    mix[4]->add(blob, 64);
+    mix[5] = new OSCMessage("/synth/voice/3/env");
+    mix[5]->add(0.01f).add(0.2f).add(0.6f).add(1.5f);
+    for(int i = 0; i < MIX_SIZE; i++)
+    {
+        packetLengths[i] = mix[i]->encode(packets[i], sizeof(packets[i]));
+    }
+}
+
+/*=============================================================================
+    HANDLERS
+ =============================================================================*/
+
+static uint32_t handled;
+
+static void onMessage(OSCMessage &)
+{
+    handled++;
+}
+
+static void onRoute(OSCMessage &, int offset)
+{
+    handled += offset;
+}
+
+#define ROUTE_COUNT 64
+
+static char routeAddresses[ROUTE_COUNT][32];
+
+// the addresses of a synth with a few voices and a mixer, the messages of
+// the mix are among them
+static void buildRoutes()
+{
+    const char *params[] = {"freq", "gain", "env", "pan"};
+    int         n        = 0;
+    for(int voice = 0; voice < 8; voice++)
+    {
+        for(int p = 0; p < 4; p++)
+        {
+            snprintf(routeAddresses[n++],
+                     32,
+                     "/synth/voice/%d/%s",
+                     voice,
+                     params[p]);
+        }
+    }
+    for(int ch = 0; ch < 16; ch++)
+    {
+        snprintf(routeAddresses[n++], 32, "/mixer/ch/%d/gain", ch);
+        snprintf(routeAddresses[n++], 32, "/mixer/ch/%d/mute", ch);
+    }
+}
+
+/*=============================================================================
+    CASES
+ =============================================================================*/
+
+static void benchDecode()
+{
+    bench("fill() byte by byte", MIX_SIZE, [] {
+        for(int i = 0; i < MIX_SIZE; i++)
+        {
+            OSCMessage msg;
+            for(int b = 0; b < packetLengths[i]; b++)
+            {
+                msg.fill(packets[i][b]);
+            }
+            sink += msg.size();
+        }
+    });
+    bench("fill() whole packet", MIX_SIZE, [] {
+        for(int i = 0; i < MIX_SIZE; i++)
+        {
+            OSCMessage msg;
+            msg.fill(packets[i], packetLengths[i]);
+            sink += msg.size();
+        }
+    });
+    bench("OSCMessageView::parse()", MIX_SIZE, [] {
+        for(int i = 0; i < MIX_SIZE; i++)
+        {
+            OSCMessageView view(packets[i], packetLengths[i]);
+            sink += view.size();
+        }
+    });
+}
+
+static void benchEncode()
+{
+    bench("bytes()", MIX_SIZE, [] {
+        for(int i = 0; i < MIX_SIZE; i++)
+        {
+            sink += mix[i]->bytes();
+        }
+    });
+    bench("encode()", MIX_SIZE, [] {
+        uint8_t buffer[256];
+        for(int i = 0; i < MIX_SIZE; i++)
+        {
+            sink += mix[i]->encode(buffer, sizeof(buffer));
+        }
+    });
+    static daisy::UartHandler uart;
+    bench("send()", MIX_SIZE, [] {
+        for(int i = 0; i < MIX_SIZE; i++)
+        {
+            mix[i]->send(uart);
+        }
+        sink += uart.checksum;
+    });
+
+    // a message carrying a block of audio
+    static uint8_t block[4096];
+    static OSCMessage blockMessage("/scope/block");
+    blockMessage.add(block, sizeof(block));
+    bench("send() 4 KB blob, copied", 1, [] {
+        blockMessage.send(uart);
+        sink += uart.checksum;
+    });
+    // stand-in for a DMA linked list, queuing a descriptor per segment
+    // reads nothing, the controller would
+    struct Descriptors
+    {
+        uint32_t queued = 0;
+        void TransmitSegments(const OSCSegment *segments, int count)
+        {
+            for(int i = 0; i < count; i++)
+            {
+                queued += segments[i].length;
+            }
+        }
+    };
+    static Descriptors dma;
+    bench("send() 4 KB blob, segments", 1, [] {
+        blockMessage.send(dma);
+        sink += dma.queued;
+    });
+}
+
+static void benchMatch()
+{
+    struct Case
+    {
+        const char *name;
+        const char *pattern;
+        const char *address;
+    };
+    // the pattern is the incoming address, as in OSCMessage::match()
+    static const Case cases[] = {
+        {"osc_match() literal hit", "/synth/voice/3/freq", "/synth/voice/3/freq"},
+        {"osc_match() literal miss", "/synth/voice/3/freq", "/mixer/ch/3/gain"},
+        {"osc_match() one star", "/synth/*/3/freq", "/synth/voice/3/freq"},
+        {"osc_match() class and alternatives",
+         "/synth/voice/[0-7]/{freq,gain}",
+         "/synth/voice/3/freq"},
+        // every star backtracks over the whole component
+        {"osc_match() pathological stars",
+         "/*a*a*a*a*a*a*b",
+         "/aaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"},
+    };
+    for(const Case &c : cases)
+    {
+        const char *pattern = c.pattern;
+        const char *address = c.address;
+        bench(c.name, 1, [pattern, address] {
+            int pattern_offset, address_offset;
+            sink += osc_match(pattern, address, &pattern_offset, &address_offset);
+        });
+    }
+
+    // the same with the pattern compiled once
+    static osc_pattern compiled;
+    osc_pattern_compile(&compiled, "/*a*a*a*a*a*a*b");
+    bench("osc_pattern_match() pathological stars", 1, [] {
+        int address_offset;
+        sink += osc_pattern_match(
+            &compiled, "/aaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", &address_offset);
+    });
+}
+
+static void benchDispatch()
+{
+    bench("dispatch() over 64 routes", MIX_SIZE, [] {
+        for(int i = 0; i < MIX_SIZE; i++)
+        {
+            for(int r = 0; r < ROUTE_COUNT; r++)
+            {
+                mix[i]->dispatch(routeAddresses[r], onMessage);
+            }
+        }
+        sink += handled;
+    });
+    bench("route() over 3 prefixes", MIX_SIZE, [] {
+        for(int i = 0; i < MIX_SIZE; i++)
+        {
+            mix[i]->route("/synth", onRoute);
+            mix[i]->route("/mixer", onRoute);
+            mix[i]->route("/seq", onRoute);
+        }
+        sink += handled;
+    });
+
+    static OSCRouter router;
+    for(int r = 0; r < ROUTE_COUNT; r++)
+    {
+        router.addRoute(routeAddresses[r], onMessage);
+    }
+    bench("OSCRouter::dispatch() 64 routes", MIX_SIZE, [] {
+        for(int i = 0; i < MIX_SIZE; i++)
+        {
+            sink += router.dispatch(*mix[i]);
+        }
+    });
+    router.addRoute("/synth", onRoute);
+    router.addRoute("/synth/voice/*/env", onMessage);
+    bench("OSCRouter::dispatch() with wildcards", MIX_SIZE, [] {
+        for(int i = 0; i < MIX_SIZE; i++)
+        {
+            sink += router.dispatch(*mix[i]);
+        }
+    });
+}
+
+// two messages of the mix as schemas
+OSC_SCHEMA_ADDRESS(SeqStep, "/seq/step");
+typedef OSCSchema<SeqStep, int32_t, int32_t> SeqStepMsg;
+OSC_SCHEMA_ADDRESS(VoiceEnv, "/synth/voice/3/env");
+typedef OSCSchema<VoiceEnv, float, float, float, float> VoiceEnvMsg;
+
+static_assert(SeqStepMsg::size == 24, "12 address, 4 tags, 8 arguments");
+static_assert(VoiceEnvMsg::size == 44, "20 address, 8 tags, 16 arguments");
+static_assert(VoiceEnvMsg::offset(3) == 40, "after the header and 3 floats");
+
+// returns false if a schema doesn't encode the bytes of its message
+static bool benchSchema()
+{
+    uint8_t buffer[64];
+    int     length = SeqStepMsg::encode(buffer, sizeof(buffer), 7, 127);
+    if(length != packetLengths[2] || memcmp(buffer, packets[2], length) != 0)
+    {
+        printf("OSCSchema encodes /seq/step differently\n");
+        return false;
+    }
+    length = VoiceEnvMsg::encode(
+        buffer, sizeof(buffer), 0.01f, 0.2f, 0.6f, 1.5f);
+    if(length != packetLengths[5] || memcmp(buffer, packets[5], length) != 0)
+    {
+        printf("OSCSchema encodes /synth/voice/3/env differently\n");
+        return false;
+    }
+
+    // the same two messages without a schema
+    bench("encode() of the schema messages", 2, [] {
+        uint8_t buffer[64];
+        sink += mix[2]->encode(buffer, sizeof(buffer));
+        sink += mix[5]->encode(buffer, sizeof(buffer));
+    });
+    bench("OSCSchema::encode()", 2, [] {
+        uint8_t buffer[64];
+        SeqStepMsg::encode(buffer, sizeof(buffer), 7, (int32_t)sink);
+        sink += buffer[SeqStepMsg::size - 1];
+        VoiceEnvMsg::encode(buffer, sizeof(buffer), 0.01f, 0.2f, 0.6f, 1.5f);
+        sink += buffer[VoiceEnvMsg::size - 1];
+    });
+    bench("OSCSchema::decode()", 2, [] {
+        // left untouched if the packet doesn't match
+        int32_t step = 0, velocity = 0;
+        float   attack = 0, decay = 0, level = 0, release = 0;
+        SeqStepMsg::decode(packets[2], packetLengths[2], step, velocity);
+        VoiceEnvMsg::decode(
+            packets[5], packetLengths[5], attack, decay, level, release);
+        sink += step + velocity + (int)(attack + decay + level + release);
+    });
+    return true;
+}
+
+// a burst of a continuous control within one audio block
+#define BURST_SIZE 16
+
+static void decodeAndDispatch(uint8_t *packet, int length, void *)
+{
+    OSCMessage msg;
+    msg.fill(packet, length);
+    msg.dispatch("/filter/cutoff", onMessage);
+}
+
+static void benchCoalesce()
+{
+    static uint8_t burst[BURST_SIZE][32];
+    static int     burstLengths[BURST_SIZE];
+    for(int i = 0; i < BURST_SIZE; i++)
+    {
+        OSCMessage msg("/filter/cutoff");
+        msg.add(100.0f + i);
+        burstLengths[i] = msg.encode(burst[i], sizeof(burst[i]));
+    }
+    bench("burst decoded and dispatched", BURST_SIZE, [] {
+        for(int i = 0; i < BURST_SIZE; i++)
+        {
+            decodeAndDispatch(burst[i], burstLengths[i], NULL);
+        }
+        sink += handled;
+    });
+    static OSCCoalescer<8> coalescer(decodeAndDispatch);
+    coalescer.coalesce("/filter/cutoff");
+    bench("burst coalesced", BURST_SIZE, [] {
+        for(int i = 0; i < BURST_SIZE; i++)
+        {
+            coalescer.push(burst[i], burstLengths[i]);
+        }
+        sink += coalescer.flush() + handled;
+    });
+}
+
+int main()
+{
+    buildMix();
+    buildRoutes();
+    benchDecode();
+    benchEncode();
+    benchMatch();
+    benchDispatch();
+    benchCoalesce();
+    return benchSchema() ? 0 : 1;
+}
@@ -0,0 +1,219 @@
+// host test of OSCParameters
+//
+// binds a small table of parameters, sets them through messages and checks
+// the scaling, the clamping, the rounding of int parameters, which
+// parameters a pattern address sets, and that the smoothers reach the
+// published value
+// see the Makefile for building it
+
+#include <math.h>
+#include <stdio.h>
+
+#include "OSCParameters.h"
+
+static int failures;
+
+#define CHECK(condition)                                                  \
+    do                                                                    \
+    {                                                                     \
+        if(!(condition))                                                  \
+        {                                                                 \
+            printf("%s:%d: failed %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                   \
+        }                                                                 \
+    } while(0)
+
+// whether a and b agree to within a relative error of about 1e-6
+static bool near(float a, float b)
+{
+    return fabsf(a - b) <= 1e-6f * fmaxf(fabsf(a), fabsf(b)) + 1e-6f;
+}
+
+// sends a message with a single float argument to the table
+template <size_t N>
+static int send(OSCParameters<N> &params, const char *address, float value)
+{
+    OSCMessage msg(address);
+    msg.add(value);
+    return params.dispatch(msg);
+}
+
+static void scaling()
+{
+    OSCParameters<4> params;
+    OSCParameter    *raw    = params.bind("/raw", -1, 1);
+    OSCParameter    *linear = params.bind("/linear", 10, 20);
+    OSCParameter    *cutoff = params.bind("/cutoff", 20, 20000);
+    // exponential scaling needs a range above 0
+    OSCParameter *pan = params.bind("/pan", -1, 1);
+    linear->scale(OSC_SCALE_LINEAR);
+    cutoff->scale(OSC_SCALE_EXPONENTIAL);
+    pan->scale(OSC_SCALE_EXPONENTIAL);
+
+    // parameters start at min
+    CHECK(raw->get() == -1);
+    CHECK(cutoff->get() == 20);
+
+    send(params, "/raw", 0.25f);
+    CHECK(raw->get() == 0.25f);
+    send(params, "/linear", 0.25f);
+    CHECK(near(linear->get(), 12.5f));
+    send(params, "/cutoff", 0);
+    CHECK(near(cutoff->get(), 20));
+    send(params, "/cutoff", 0.5f);
+    CHECK(near(cutoff->get(), 20 * sqrtf(1000)));
+    send(params, "/cutoff", 1);
+    CHECK(near(cutoff->get(), 20000));
+    send(params, "/pan", 0.75f);
+    CHECK(near(pan->get(), 0.5f));
+}
+
+static void clamping()
+{
+    OSCParameters<2> params;
+    OSCParameter    *gain   = params.bind("/gain", 0, 2);
+    OSCParameter    *linear = params.bind("/linear", 100, 200);
+    linear->scale(OSC_SCALE_LINEAR);
+
+    send(params, "/gain", 3);
+    CHECK(gain->get() == 2);
+    send(params, "/gain", -1);
+    CHECK(gain->get() == 0);
+    send(params, "/gain", 1);
+    send(params, "/gain", NAN);
+    CHECK(gain->get() == 0);
+    send(params, "/gain", INFINITY);
+    CHECK(gain->get() == 2);
+
+    // the range is clamped after scaling
+    send(params, "/linear", 1.5f);
+    CHECK(linear->get() == 200);
+    send(params, "/linear", NAN);
+    CHECK(linear->get() == 100);
+}
+
+static void integers()
+{
+    OSCParameters<1> params;
+    OSCParameter    *step = params.bindInt("/step", 0, 15);
+    CHECK(step->isInt());
+    CHECK(step->getInt() == 0);
+
+    send(params, "/step", 2.4f);
+    CHECK(step->getInt() == 2);
+    send(params, "/step", 2.5f);
+    CHECK(step->getInt() == 3);
+    CHECK(step->get() == 3);
+    send(params, "/step", 15.4f);
+    CHECK(step->getInt() == 15);
+    send(params, "/step", NAN);
+    CHECK(step->getInt() == 0);
+
+    // every numeric argument type sets a parameter
+    OSCMessage msg("/step");
+    msg.add((int32_t)7);
+    CHECK(params.dispatch(msg) == 1);
+    CHECK(step->getInt() == 7);
+    msg.empty().add(9.6);
+    CHECK(params.dispatch(msg) == 1);
+    CHECK(step->getInt() == 10);
+    msg.empty().add(true);
+    CHECK(params.dispatch(msg) == 1);
+    CHECK(step->getInt() == 1);
+}
+
+static void dispatching()
+{
+    OSCParameters<4> params;
+    OSCParameter    *gain1 = params.bind("/mixer/1/gain", 0, 1);
+    OSCParameter    *gain2 = params.bind("/mixer/2/gain", 0, 1);
+    OSCParameter    *mute1 = params.bind("/mixer/1/mute", 0, 1);
+    CHECK(params.size() == 3);
+    CHECK(params.find("/mixer/2/gain") == gain2);
+    CHECK(params.find("/mixer/3/gain") == NULL);
+
+    CHECK(send(params, "/mixer/1/gain", 0.5f) == 1);
+    CHECK(gain1->get() == 0.5f);
+    CHECK(gain2->get() == 0);
+    CHECK(send(params, "/mixer/3/gain", 0.5f) == 0);
+    CHECK(send(params, "/mixer/1/gai", 0.5f) == 0);
+
+    // a pattern address sets every parameter it matches
+    CHECK(send(params, "/mixer/*/gain", 0.25f) == 2);
+    CHECK(gain1->get() == 0.25f);
+    CHECK(gain2->get() == 0.25f);
+    CHECK(mute1->get() == 0);
+    CHECK(send(params, "/mixer/1/{gain,mute}", 1) == 2);
+    CHECK(gain1->get() == 1);
+    CHECK(mute1->get() == 1);
+
+    // messages without a single numeric argument set nothing
+    OSCMessage msg("/mixer/1/gain");
+    msg.add(0.5f).add(0.5f);
+    CHECK(params.dispatch(msg) == 0);
+    msg.empty().add("loud");
+    CHECK(params.dispatch(msg) == 0);
+    CHECK(gain1->get() == 1);
+}
+
+static void smoothing()
+{
+    OSCParameters<2> params;
+    OSCParameter    *ramp = params.bind("/ramp", 0, 1000);
+    OSCParameter    *pole = params.bind("/pole", 0, 1);
+    ramp->smooth(OSC_SMOOTH_LINEAR, 480);
+    pole->smooth(OSC_SMOOTH_ONE_POLE, 48);
+
+    // the ramp lands on the target after exactly that many samples
+    send(params, "/ramp", 333.3f);
+    for(int i = 0; i < 479; i++)
+    {
+        CHECK(ramp->next() < 333.3f);
+    }
+    CHECK(ramp->next() == 333.3f);
+    CHECK(ramp->next() == 333.3f);
+
+    // and starts over from where it is when the value changes midway
+    send(params, "/ramp", 0.1f);
+    for(int i = 0; i < 240; i++)
+    {
+        ramp->next();
+    }
+    send(params, "/ramp", 1000);
+    for(int i = 0; i < 479; i++)
+    {
+        CHECK(ramp->next() < 1000);
+    }
+    CHECK(ramp->next() == 1000);
+
+    // the one pole covers 1 - 1/e of a step in the time constant
+    send(params, "/pole", 1);
+    float value = 0;
+    for(int i = 0; i < 48; i++)
+    {
+        value = pole->next();
+    }
+    CHECK(fabsf(value - (1 - expf(-1))) < 1e-3f);
+    // and settles as close as the float steps of the coefficient allow
+    for(int i = 0; i < 48 * 20; i++)
+    {
+        value = pole->next();
+    }
+    CHECK(fabsf(value - 1) < 1e-5f);
+}
+
+int main()
+{
+    scaling();
+    clamping();
+    integers();
+    dispatching();
+    smoothing();
+    if(failures > 0)
+    {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
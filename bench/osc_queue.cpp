@@ -0,0 +1,167 @@
+// host test of OSCMessageQueue
+//
+// one thread produces sequenced messages, another consumes them, the
+// consumer checks that they arrive in order, and that none is lost or seen
+// twice beyond what the queue reports as dropped
+// the queue is small so that the counters wrap around it many times and it
+// runs full often, see the Makefile for building it
+
+#include <atomic>
+#include <stdio.h>
+#include <thread>
+
+#include "OSCMessageQueue.h"
+
+#define QUEUE_SIZE 8
+#define MESSAGE_COUNT 200000
+
+static int failures;
+
+#define CHECK(condition)                                                  \
+    do                                                                    \
+    {                                                                     \
+        if(!(condition))                                                  \
+        {                                                                 \
+            printf("%s:%d: failed %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                   \
+        }                                                                 \
+    } while(0)
+
+// the encoded message with that sequence number
+static int encodeSequenced(uint8_t *buffer, int size, int32_t sequence)
+{
+    OSCMessage msg("/seq");
+    // a string argument makes releasing free memory
+    msg.add(sequence).add("payload");
+    return msg.encode(buffer, size);
+}
+
+static int32_t sequenceOf(OSCMessage &msg)
+{
+    if(msg.size() != 2 || !msg.isInt(0) || !msg.isString(1))
+    {
+        return -1;
+    }
+    return msg.getInt(0);
+}
+
+// without threads, the exact results of a full queue
+static void fullQueue(OSCOverflowPolicy policy)
+{
+    OSCMessageQueue<QUEUE_SIZE> queue(policy);
+    uint8_t                     packet[64];
+    // goes round the slots twice before filling them
+    for(int32_t i = 0; i < 2 * QUEUE_SIZE; i++)
+    {
+        CHECK(queue.push(packet, encodeSequenced(packet, sizeof(packet), i)));
+        OSCMessage *msg = queue.peek();
+        CHECK(msg != NULL && sequenceOf(*msg) == i);
+        queue.release();
+    }
+    for(int32_t i = 0; i < QUEUE_SIZE + 2; i++)
+    {
+        bool pushed
+            = queue.push(packet, encodeSequenced(packet, sizeof(packet), i));
+        CHECK(pushed == (i < QUEUE_SIZE || policy == OSC_DROP_OLDEST));
+    }
+    CHECK(queue.size() == QUEUE_SIZE);
+    CHECK(queue.dropped() == 2);
+    // the newest are kept when dropping the oldest
+    int32_t expected = policy == OSC_DROP_OLDEST ? 2 : 0;
+    for(int i = 0; i < QUEUE_SIZE; i++)
+    {
+        OSCMessage *msg = queue.peek();
+        CHECK(msg != NULL && sequenceOf(*msg) == expected++);
+        queue.release();
+    }
+    CHECK(queue.peek() == NULL);
+}
+
+// with OSC_DROP_NEWEST the producer retries each message until the queue
+// takes it, every refusal counts as a drop but no message may be lost
+// with OSC_DROP_OLDEST it pushes each message once, the dropped ones are
+// missing from the sequence
+static void threaded(OSCOverflowPolicy policy)
+{
+    static OSCMessageQueue<QUEUE_SIZE> *queue;
+    static std::atomic<uint32_t>        refused;
+    queue = new OSCMessageQueue<QUEUE_SIZE>(policy);
+    refused.store(0);
+
+    std::thread producer([policy] {
+        uint8_t packet[64];
+        for(int32_t i = 0; i < MESSAGE_COUNT; i++)
+        {
+            int length = encodeSequenced(packet, sizeof(packet), i);
+            while(!queue->push(packet, length) && policy == OSC_DROP_NEWEST)
+            {
+                refused++;
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    int32_t  last     = -1;
+    uint32_t received = 0;
+    while(true)
+    {
+        OSCMessage *msg = queue->peek();
+        if(msg == NULL)
+        {
+            if(last == MESSAGE_COUNT - 1
+               || (policy == OSC_DROP_OLDEST
+                   && received + queue->dropped() == MESSAGE_COUNT))
+            {
+                break;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        int32_t sequence = sequenceOf(*msg);
+        // in order, without duplicates
+        CHECK(sequence > last);
+        if(policy == OSC_DROP_NEWEST)
+        {
+            // and without gaps
+            CHECK(sequence == last + 1);
+        }
+        last = sequence;
+        received++;
+        queue->release();
+    }
+    producer.join();
+
+    CHECK(queue->peek() == NULL);
+    if(policy == OSC_DROP_NEWEST)
+    {
+        CHECK(received == MESSAGE_COUNT);
+        CHECK(queue->pushed() == received);
+        CHECK(queue->dropped() == refused.load());
+    }
+    else
+    {
+        // the oldest were published before they were dropped
+        CHECK(received + queue->dropped() == MESSAGE_COUNT);
+        CHECK(queue->pushed() >= received);
+    }
+    printf("%s: %u received, %u dropped\n",
+           policy == OSC_DROP_NEWEST ? "drop newest" : "drop oldest",
+           received,
+           queue->dropped());
+    delete queue;
+}
+
+int main()
+{
+    fullQueue(OSC_DROP_NEWEST);
+    fullQueue(OSC_DROP_OLDEST);
+    threaded(OSC_DROP_NEWEST);
+    threaded(OSC_DROP_OLDEST);
+    if(failures > 0)
+    {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,172 @@
+// host stand-in for clock synchronization
+//
+// plays both sides of the exchange in one process, the host's clock running
+// from the local one with an epoch and a drift, the link adding random
+// delays and the occasional queueing spike, the messages are encoded and
+// decoded as they would be on a real link
+//
+// the first part runs ten minutes of exchanges on simulated time and reports
+// how closely the estimate follows the host's clock, the second runs a few
+// exchanges in real time and checks oscTime() itself
+// it fails if the estimate strays further than the bounds below, which leave
+// room above what the simulated link gives, about 30 us and 4 ppm at worst
+// see the Makefile for building it
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "OSCSync.h"
+
+#define SECOND (1ULL << 32)
+#define MICROS(us) ((uint64_t)(us) * SECOND / 1000000)
+
+// the bounds, once the first minute of exchanges is in
+static const double maxErrorMicros     = 50;
+static const double maxDriftErrorPpm   = 6;
+static const double maxRealErrorMicros = 1000;
+
+static int failures;
+
+// the host's clock against the local one
+static const double hostDrift = 50e-6;
+static uint64_t     hostEpoch;
+
+static uint64_t hostTime(uint64_t local)
+{
+    return hostEpoch + local + (uint64_t)(int64_t)(local * hostDrift);
+}
+
+// the delay of one way of a USB serial link, in microseconds
+static int linkDelay()
+{
+    // one message in ten waits behind others
+    if(rand() % 10 == 0)
+    {
+        return 2000 + rand() % 3000;
+    }
+    return 250 + rand() % 100;
+}
+
+// sends the message over the link into received
+static void transfer(OSCMessage &msg, OSCMessage &received)
+{
+    uint8_t buffer[64];
+    int     length = msg.encode(buffer, sizeof(buffer));
+    received.empty();
+    received.fill(buffer, length);
+}
+
+static double toMicros(int64_t fixed)
+{
+    return fixed * 1e6 / SECOND;
+}
+
+static void simulated()
+{
+    OSCSync    sync(false);
+    OSCMessage request, reply, atHost, atDaisy;
+
+    printf("simulated, one exchange a second\n");
+    printf("%8s %12s %12s %10s %10s %10s\n",
+           "seconds",
+           "error us",
+           "drift ppm",
+           "delay us",
+           "spread us",
+           "confidence");
+    uint64_t now = SECOND;
+    for(int i = 1; i <= 600; i++)
+    {
+        sync.request(request, now);
+        transfer(request, atHost);
+        now += MICROS(linkDelay());
+
+        uint64_t received = hostTime(now);
+        now += MICROS(50);
+        oscSyncRespond(atHost,
+                       reply,
+                       oscTimeFromFixed(received),
+                       oscTimeFromFixed(hostTime(now)));
+        transfer(reply, atDaisy);
+        now += MICROS(linkDelay());
+        sync.receive(atDaisy, now);
+
+        int64_t error = (int64_t)(now + sync.getOffset(now) - hostTime(now));
+        if(i >= 60
+           && (fabs(toMicros(error)) > maxErrorMicros
+               || fabs(sync.getDrift() - hostDrift) * 1e6 > maxDriftErrorPpm))
+        {
+            printf("after %d s: error %.1f us, drift %.2f ppm out of bounds\n",
+                   i,
+                   toMicros(error),
+                   sync.getDrift() * 1e6);
+            failures++;
+        }
+        if(i % 60 == 0)
+        {
+            printf("%8d %12.1f %12.2f %10.1f %10.1f %10.2f\n",
+                   i,
+                   toMicros(error),
+                   sync.getDrift() * 1e6,
+                   sync.getDelay() * 1e6,
+                   sync.getError() * 1e6,
+                   sync.getConfidence());
+        }
+        now += SECOND;
+    }
+}
+
+static void sleepMicros(int micros)
+{
+    struct timespec ts = {0, micros * 1000L};
+    nanosleep(&ts, NULL);
+}
+
+static void realTime()
+{
+    OSCSync    sync;
+    OSCMessage request, reply, atHost, atDaisy;
+
+    for(int i = 0; i < OSC_SYNC_SAMPLES; i++)
+    {
+        sync.request(request);
+        transfer(request, atHost);
+        sleepMicros(linkDelay());
+
+        osctime_t received = oscTimeFromFixed(hostTime(oscTimeMonotonic()));
+        sleepMicros(50);
+        oscSyncRespond(atHost,
+                       reply,
+                       received,
+                       oscTimeFromFixed(hostTime(oscTimeMonotonic())));
+        transfer(reply, atDaisy);
+        sleepMicros(linkDelay());
+        sync.receive(atDaisy);
+        sleepMicros(10000);
+    }
+    uint64_t local = oscTimeMonotonic();
+    int64_t  error = (int64_t)(oscTimeToFixed(oscTime()) - hostTime(local));
+    printf("real time, oscTime() against the host %.1f us\n", toMicros(error));
+    if(fabs(toMicros(error)) > maxRealErrorMicros)
+    {
+        printf("out of bounds\n");
+        failures++;
+    }
+}
+
+int main()
+{
+    srand(1);
+    hostEpoch = oscTimeToFixed(oscTimeFromUnix((uint32_t)time(NULL), 0));
+    simulated();
+    realTime();
+    if(failures > 0)
+    {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
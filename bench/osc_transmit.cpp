@@ -0,0 +1,165 @@
+// host test of OSCTransmitQueue
+//
+// drives the queue through the UART stand-in, whose DMA transfers complete
+// only when the test says so, as the interrupt would on the target, and
+// checks what is sent and what is counted as dropped when the queue fills,
+// when the transport refuses a transfer and when a transfer fails
+// see the Makefile for building it
+
+#include <stdio.h>
+
+#include "OSCTransmitQueue.h"
+#include "per/uart.h"
+
+#define MAX_QUEUED 4
+
+static int failures;
+
+#define CHECK(condition)                                                  \
+    do                                                                    \
+    {                                                                     \
+        if(!(condition))                                                  \
+        {                                                                 \
+            printf("%s:%d: failed %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                   \
+        }                                                                 \
+    } while(0)
+
+typedef OSCTransmitQueue<daisy::UartHandler, MAX_QUEUED> Queue;
+
+// the sum of the message's bytes, as the stand-in's checksum counts them
+static uint32_t checksumOf(OSCMessage &msg)
+{
+    uint8_t  buffer[64];
+    int      length = msg.encode(buffer, sizeof(buffer));
+    uint32_t sum    = 0;
+    for(int i = 0; i < length; i++)
+    {
+        sum += buffer[i];
+    }
+    return sum;
+}
+
+// completes transfers until the queue is idle
+// returns the number of transfers
+static int drain(daisy::UartHandler &uart)
+{
+    int transfers = 0;
+    while(uart.completeTransfer())
+    {
+        transfers++;
+    }
+    return transfers;
+}
+
+static void fillAndDrain()
+{
+    daisy::UartHandler uart;
+    uint8_t            arena[256];
+    Queue              queue(uart, arena, sizeof(arena));
+    OSCMessage         msg("/tx");
+    uint32_t           expected = 0;
+
+    for(int32_t i = 0; i < MAX_QUEUED; i++)
+    {
+        msg.empty().add(i);
+        CHECK(queue.send(msg));
+        expected += checksumOf(msg);
+    }
+    // the first is in flight, nothing has completed
+    CHECK(uart.isTransferring());
+    CHECK(queue.isBusy());
+    CHECK(queue.depth() == MAX_QUEUED);
+    CHECK(uart.transmits == 0);
+
+    msg.empty().add(MAX_QUEUED);
+    CHECK(!queue.send(msg));
+    CHECK(queue.dropped() == 1);
+
+    CHECK(drain(uart) == MAX_QUEUED);
+    CHECK(queue.depth() == 0);
+    CHECK(!queue.isBusy());
+    CHECK(uart.transmits == MAX_QUEUED);
+    CHECK(uart.checksum == expected);
+    CHECK(queue.dropped() == 1);
+}
+
+// an arena with room for three messages, so that the queued messages keep
+// wrapping around to its start
+static void wrapAround()
+{
+    daisy::UartHandler uart;
+    uint8_t            arena[40];
+    Queue              queue(uart, arena, sizeof(arena));
+    OSCMessage         msg("/tx");
+    uint32_t           expected = 0;
+    uint64_t           bytes    = 0;
+
+    for(int32_t i = 0; i < 1000; i++)
+    {
+        msg.empty().add(i);
+        CHECK(queue.send(msg));
+        expected += checksumOf(msg);
+        bytes += msg.bytes();
+        // two messages stay queued, one of them in flight
+        if(i > 0)
+        {
+            uart.completeTransfer();
+        }
+    }
+    drain(uart);
+    CHECK(queue.dropped() == 0);
+    CHECK(uart.bytesSent == bytes);
+    CHECK(uart.checksum == expected);
+}
+
+static void refusedAndFailed()
+{
+    daisy::UartHandler uart;
+    uint8_t            arena[256];
+    Queue              queue(uart, arena, sizeof(arena));
+    OSCMessage         msg("/tx");
+    msg.add(1);
+
+    // a refused transfer drops its message once and leaves the queue idle
+    uart.refuseTransfers = 1;
+    CHECK(queue.send(msg));
+    CHECK(queue.dropped() == 1);
+    CHECK(queue.depth() == 0);
+    CHECK(!queue.isBusy());
+
+    // a failed transfer drops its message once, the next one still goes
+    uart.failTransfers = 1;
+    CHECK(queue.send(msg));
+    CHECK(queue.send(msg));
+    CHECK(drain(uart) == 2);
+    CHECK(queue.dropped() == 2);
+    CHECK(queue.depth() == 0);
+    CHECK(!queue.isBusy());
+    CHECK(uart.transmits == 1);
+
+    // refused while completing, the rest of the queue is still sent
+    CHECK(queue.send(msg));
+    CHECK(queue.send(msg));
+    CHECK(queue.send(msg));
+    uart.refuseTransfers = 1;
+    CHECK(drain(uart) == 2);
+    CHECK(queue.dropped() == 3);
+    CHECK(queue.depth() == 0);
+    CHECK(!queue.isBusy());
+    CHECK(uart.transmits == 3);
+}
+
+int main()
+{
+    fillAndDrain();
+    wrapAround();
+    refusedAndFailed();
+    if(failures > 0)
+    {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
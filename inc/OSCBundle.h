@@ -0,0 +1,256 @@
+#pragma once
+
+#include <string.h>
+
+#include "daisy_core.h"
+#include "OSCMessage.h"
+#include "OSCMessageView.h"
+#include "OSCTiming.h"
+
+// the deepest nesting of bundles OSCBundleView::forEach() follows, each
+// level takes a stack frame
+#ifndef OSC_BUNDLE_MAX_DEPTH
+#define OSC_BUNDLE_MAX_DEPTH 8
+#endif
+
+class OSCBundle
+{
+    // an element is either a message or a nested bundle
+    struct Element
+    {
+        OSCMessage *message;
+        OSCBundle  *bundle;
+    };
+
+    // the time at which the contents should be applied
+    osctime_t timetag;
+
+    // the elements, owned by the bundle
+    Element *elements;
+
+    // the number of elements in the array
+    int elementCount;
+
+    // the number of elements the array has room for
+    int elementCapacity;
+
+    // error codes for potential runtime problems
+    OSCErrorCode error;
+
+    // makes room for one more element
+    Element *reserveElement();
+
+    // writes the wire image at ptr without checking its size
+    // returns the end of the image
+    uint8_t *encodeTo(uint8_t *ptr);
+
+    // writes the wire image to an OSCSegmentWriter
+    template <typename W>
+    void writeTo(W &writer)
+    {
+        uint8_t header[16];
+        memcpy(header, "#bundle", 8);
+        uint32_t word = BigEndian(timetag.seconds);
+        memcpy(header + 8, &word, 4);
+        word = BigEndian(timetag.fractionofseconds);
+        memcpy(header + 12, &word, 4);
+        writer.copy(header, 16);
+        for(int i = 0; i < elementCount; i++)
+        {
+            Element &e = elements[i];
+            word = BigEndian((uint32_t)(e.message ? e.message->bytes()
+                                                  : e.bundle->bytes()));
+            writer.copy(&word, 4);
+            if(e.message)
+            {
+                e.message->writeTo(writer);
+            }
+            else
+            {
+                e.bundle->writeTo(writer);
+            }
+        }
+    }
+
+    // bundles come from the pools when built with OSC_NO_HEAP
+    OSC_POOL_ALLOCATED
+
+  public:
+    /*=============================================================================
+    CONSTRUCTORS / DESTRUCTOR
+  =============================================================================*/
+
+    // a bundle is immediate unless given a timetag
+    OSCBundle(osctime_t = oscTimeImmediate);
+
+    // DESTRUCTOR
+    ~OSCBundle();
+
+    // deletes all of the elements
+    OSCBundle &empty();
+
+    /*=============================================================================
+    SETTING DATA
+  =============================================================================*/
+
+    // creates a message at the end of the bundle and returns it
+    // so that its data can be added
+    // returns NULL and sets ALLOCFAILED if it can't be allocated
+    OSCMessage *add(const char *address);
+
+    // copies a message to the end of the bundle
+    // returns NULL and sets ALLOCFAILED if it can't be allocated
+    OSCMessage *add(OSCMessage &msg);
+
+    // creates a nested bundle at the end of the bundle and returns it
+    // returns NULL and sets ALLOCFAILED if it can't be allocated
+    OSCBundle *addBundle(osctime_t = oscTimeImmediate);
+
+    OSCBundle &setTimetag(osctime_t);
+
+    /*=============================================================================
+    GETTING DATA
+  =============================================================================*/
+
+    osctime_t getTimetag() { return timetag; }
+
+    // returns the message at that position, NULL for nested bundles
+    OSCMessage *getOSCMessage(int position);
+
+    // returns the first message that fully matches the address
+    // nested bundles are not searched
+    OSCMessage *getOSCMessage(const char *address);
+
+    // returns the nested bundle at that position, NULL for messages
+    OSCBundle *getBundle(int position);
+
+    /*=============================================================================
+    PATTERN MATCHING
+  =============================================================================*/
+
+    // dispatches every message in the bundle and its nested bundles
+    // returns true if any of them matched
+    bool dispatch(const char *pattern, void (*callback)(OSCMessage &), int = 0);
+
+    // routes every message in the bundle and its nested bundles
+    bool
+    route(const char *pattern, void (*callback)(OSCMessage &, int), int = 0);
+
+    /*=============================================================================
+    SIZE
+  =============================================================================*/
+
+    // the number of elements in the bundle
+    int size() { return elementCount; }
+
+    // the number of bytes the bundle occupies once encoded
+    int bytes();
+
+    /*=============================================================================
+    TRANSMISSION
+  =============================================================================*/
+
+    // writes the bundle's wire image to the buffer in one pass
+    // returns the number of bytes the bundle needs
+    // nothing is written if that is more than bufferSize
+    // returns 0 for a bundle with errors
+    int encode(uint8_t *buffer, size_t bufferSize);
+
+    // send the bundle with a single transmit call
+    // using the passed buffer to hold the wire image
+    template <typename T>
+    OSCBundle &send(T &p, uint8_t *buffer, size_t bufferSize)
+    {
+        if(hasError())
+        {
+            return *this;
+        }
+        int bundleSize = encode(buffer, bufferSize);
+        if((size_t)bundleSize > bufferSize)
+        {
+            error = BUFFER_FULL;
+            return *this;
+        }
+        p.BlockingTransmit(buffer, bundleSize);
+        return *this;
+    }
+
+    // send the bundle, with a single transmit call when it is small
+    // see OSCSegment.h for the transports it works with
+    template <typename T>
+    OSCBundle &send(T &p)
+    {
+        if(hasError())
+        {
+            return *this;
+        }
+        OSCSegmentWriter<T> writer(p);
+        // small bundles are encoded in one go
+        if(!writer.encode(*this))
+        {
+            writeTo(writer);
+        }
+        writer.flush();
+        return *this;
+    }
+
+    /*=============================================================================
+    ERROR
+  =============================================================================*/
+
+    bool         hasError();
+    OSCErrorCode getError() { return error; }
+};
+
+// read-only view of a received bundle
+// the elements are returned as pointers into the packet, nothing is copied
+class OSCBundleView
+{
+    // the packet
+    const uint8_t *buffer;
+
+    // the number of bytes in the packet
+    int length;
+
+    // the offset of the next element to read
+    int cursor;
+
+    // error codes for potential runtime problems
+    OSCErrorCode error;
+
+    // forEach() within that many enclosing bundles
+    int forEach(void (*callback)(OSCMessageView &, osctime_t, void *),
+                void *context,
+                int   depth);
+
+  public:
+    OSCBundleView();
+    // parses the packet right away
+    OSCBundleView(const uint8_t *packet, int packetLength);
+
+    // checks the bundle header and rewinds to the first element
+    OSCErrorCode parse(const uint8_t *packet, int packetLength);
+
+    // whether the packet starts like a bundle
+    static bool isBundle(const uint8_t *packet, int packetLength);
+
+    // the time at which the contents should be applied
+    osctime_t getTimetag();
+
+    // returns the next element in the packet and moves past it
+    // returns false once all elements were read or if an element is malformed
+    bool next(const uint8_t **element, int *elementLength);
+
+    // goes back to the first element
+    void rewind() { cursor = 16; }
+
+    // calls the function for every message in the bundle and its nested bundles
+    // with the timetag of the bundle that contains the message
+    // returns the number of messages, or -1 if the bundle is malformed or
+    // nests bundles deeper than OSC_BUNDLE_MAX_DEPTH
+    int forEach(void (*callback)(OSCMessageView &, osctime_t, void *),
+                void *context = NULL);
+
+    bool         hasError() { return error != OSC_OK; }
+    OSCErrorCode getError() { return error; }
+};
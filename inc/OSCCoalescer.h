@@ -0,0 +1,230 @@
+#pragma once
+
+#include <string.h>
+
+#include "daisy_core.h"
+#include "OSCFraming.h"
+#include "OSCHash.h"
+
+// the largest packet a slot of the coalescer holds
+#ifndef OSC_COALESCE_PACKET_SIZE
+#define OSC_COALESCE_PACKET_SIZE 64
+#endif
+
+// keeps only the newest packet per address and type tags within a
+// processing window, for continuous controls sent faster than they are used
+//
+// packets go in between receiving and decoding, on registered addresses
+// they are held in a slot keyed by the hash of the address and the type
+// tags, a newer packet with the same key replaces the held one, flush()
+// then hands each held packet to the callback once, in the order their
+// keys first arrived
+// packets on other addresses, bundles and packets too large for a slot
+// are handed to the callback right away, in order, so they reach it before
+// the held packets of the same window
+// once all the slots are taken, packets with new keys pass through as well
+//
+//   OSCCoalescer<16> coalescer(onPacket);
+//   coalescer.coalesce("/filter/cutoff");
+//   for every received packet:
+//       coalescer.push(packet, length);
+//   once per audio block:
+//       coalescer.flush();
+//
+// only registered literal addresses are coalesced, the addresses are not
+// copied and must outlive the coalescer
+// the coalescer is not safe to use from an interrupt and the main loop at
+// the same time
+template <size_t Slots, size_t PacketSize = OSC_COALESCE_PACKET_SIZE>
+class OSCCoalescer
+{
+    static_assert(Slots > 0 && (Slots & (Slots - 1)) == 0,
+                  "OSCCoalescer slot count must be a power of two");
+
+    struct Address
+    {
+        uint32_t    hash;
+        const char *address;
+    };
+
+    struct Slot
+    {
+        uint32_t key; // hash of the address and the type tags
+        int      length;
+        uint8_t  packet[PacketSize];
+    };
+
+    Address addresses[Slots];
+    int     addressCount;
+
+    Slot slots[Slots];
+    bool taken[Slots];
+
+    // the taken slots in the order their keys arrived
+    int order[Slots];
+    int held;
+
+    OSCPacketCallback callback;
+    void             *context;
+
+    // counters
+    uint32_t pushCount;
+    uint32_t replaceCount;
+
+    // whether the address was registered
+    bool isCoalesced(const char *address, uint32_t hash)
+    {
+        for(int i = 0; i < addressCount; i++)
+        {
+            if(addresses[i].hash == hash
+               && strcmp(addresses[i].address, address) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // the length of the string at the start of the bytes, -1 if it isn't
+    // terminated within them
+    static int stringLength(const uint8_t *bytes, int size)
+    {
+        const uint8_t *end = (const uint8_t *)memchr(bytes, '\0', size);
+        return end != NULL ? (int)(end - bytes) : -1;
+    }
+
+    // whether the slot holds a packet with the same address and type tags
+    static bool holds(Slot &slot, uint32_t key, uint8_t *packet, int prefix)
+    {
+        return slot.key == key && slot.length >= prefix
+               && memcmp(slot.packet, packet, prefix) == 0;
+    }
+
+    // holds the packet, returns false if there is no slot for it
+    bool hold(uint8_t *packet, int length)
+    {
+        if(length > (int)PacketSize)
+        {
+            return false;
+        }
+        const char *address       = (const char *)packet;
+        int         addressLength = stringLength(packet, length);
+        if(addressLength <= 0 || address[0] == '#')
+        {
+            return false;
+        }
+        uint32_t hash = oscHash(address, addressLength);
+        if(!isCoalesced(address, hash))
+        {
+            return false;
+        }
+        int typesOffset = (addressLength + 4) & ~3;
+        if(typesOffset >= length || packet[typesOffset] != ',')
+        {
+            return false;
+        }
+        const char *types = (const char *)packet + typesOffset;
+        int         typesLength
+            = stringLength(packet + typesOffset, length - typesOffset);
+        if(typesLength < 0)
+        {
+            return false;
+        }
+        uint32_t key = oscHash(types, typesLength, hash);
+        // the address and the type tags up to the terminator
+        int prefix = typesOffset + typesLength + 1;
+
+        // keys are only added within a window, linear probing needs no
+        // deletions
+        // a slot holding a colliding key is passed over like any other
+        size_t index = key & (Slots - 1);
+        size_t probe = 0;
+        while(probe < Slots && taken[index]
+              && !holds(slots[index], key, packet, prefix))
+        {
+            index = (index + 1) & (Slots - 1);
+            probe++;
+        }
+        if(probe == Slots)
+        {
+            // every slot holds other type tags or another address
+            return false;
+        }
+        Slot &slot = slots[index];
+        if(taken[index])
+        {
+            replaceCount++;
+        }
+        else
+        {
+            taken[index]  = true;
+            order[held++] = (int)index;
+            slot.key      = key;
+        }
+        slot.length = length;
+        memcpy(slot.packet, packet, length);
+        return true;
+    }
+
+  public:
+    // the callback receives every packet that leaves the coalescer
+    OSCCoalescer(OSCPacketCallback _callback, void *_context = NULL)
+    : addressCount(0),
+      held(0),
+      callback(_callback),
+      context(_context),
+      pushCount(0),
+      replaceCount(0)
+    {
+        memset(taken, 0, sizeof(taken));
+    }
+
+    // registers an address whose packets are coalesced
+    // returns false once Slots addresses are registered
+    bool coalesce(const char *address)
+    {
+        if(addressCount == (int)Slots)
+        {
+            return false;
+        }
+        addresses[addressCount].hash    = oscHash(address);
+        addresses[addressCount].address = address;
+        addressCount++;
+        return true;
+    }
+
+    // takes a received packet, which is either held or handed on right away
+    void push(uint8_t *packet, int length)
+    {
+        pushCount++;
+        if(!hold(packet, length))
+        {
+            callback(packet, length, context);
+        }
+    }
+
+    // hands the held packets on and starts a new window
+    // the callback must not push while the coalescer flushes
+    // returns the number of packets handed on
+    int flush()
+    {
+        int count = held;
+        for(int i = 0; i < count; i++)
+        {
+            Slot &slot = slots[order[i]];
+            callback(slot.packet, slot.length, context);
+            taken[order[i]] = false;
+        }
+        held = 0;
+        return count;
+    }
+
+    // the number of packets held in the current window
+    int size() { return held; }
+
+    // the number of packets pushed
+    uint32_t pushed() { return pushCount; }
+
+    // the number of packets replaced by a newer one
+    uint32_t replaced() { return replaceCount; }
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "daisy_core.h"
+
+#if !defined(__arm__)
+#include <atomic>
+#endif
+
+// a short critical section, for state shared between the main loop and
+// interrupts which doesn't fit in a single atomic
+//
+// on the target it masks interrupts for the lifetime of the object, on the
+// host, where threads stand in for interrupts, it spins on a single lock
+// it must only be held for a few instructions and never nested
+class OSCCriticalSection
+{
+#if defined(__arm__)
+    uint32_t primask;
+
+  public:
+    OSCCriticalSection()
+    {
+        asm volatile("mrs %0, primask\n\tcpsid i" : "=r"(primask)::"memory");
+    }
+    ~OSCCriticalSection()
+    {
+        asm volatile("msr primask, %0" ::"r"(primask) : "memory");
+    }
+#else
+    static std::atomic_flag &flag()
+    {
+        static std::atomic_flag f = ATOMIC_FLAG_INIT;
+        return f;
+    }
+
+  public:
+    OSCCriticalSection()
+    {
+        while(flag().test_and_set(std::memory_order_acquire)) {}
+    }
+    ~OSCCriticalSection() { flag().clear(std::memory_order_release); }
+#endif
+};
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <type_traits>
+
 #include "daisy_core.h"
 #include "OSCTiming.h"
+#include "OSCPool.h"
 
-typedef enum
+// stored in a single byte so that argument slots stay compact
+typedef enum : uint8_t
 {
     OSC_OK = 0,
     BUFFER_FULL,
@@ -22,17 +26,13 @@ class OSCData
     // leaves an invalid OSCMessage with a type, but no data
     OSCData(char t);
 
-  public:
-    // an error flag
-    OSCErrorCode error;
-
-    // the size (in bytes) of the data
-    int bytes;
-
-    // the type of the data
-    uint8_t type;
+    // a blob whose content stays where it is, see borrowed
+    OSCData(uint8_t *content, uint32_t length, bool);
 
+  public:
     // the data
+    // strings and blobs point to their own allocation,
+    // every other type is stored inline
     union
     {
         char     *s; // string
@@ -44,10 +44,32 @@ class OSCData
         osctime_t time;
     } data;
 
+    // the size (in bytes) of the data
+    int bytes;
+
+    // the type of the data
+    uint8_t type;
+
+    // an error flag
+    OSCErrorCode error;
+
+    // whether a blob's content belongs to someone else, data.b then points
+    // at the content without the length in front, or is NULL when the
+    // content was handed on without being kept, see OSCBlobHandler
+    bool borrowed;
+
     // overload the constructor to account for all the types and sizes
     OSCData(const char *s);
-    OSCData(int);
     OSCData(int32_t);
+    // other integers of up to 32 bits, int among them where int32_t is a long
+    template <typename I,
+              typename std::enable_if<std::is_integral<I>::value
+                                          && sizeof(I) <= 4,
+                                      int>::type
+              = 0>
+    OSCData(I i) : OSCData((int32_t)i)
+    {
+    }
     OSCData(float);
     OSCData(double);
     OSCData(uint8_t *, int);
@@ -69,6 +91,8 @@ class OSCData
     int       getBlob(uint8_t *, int);
     int       getBlob(uint8_t *, int, int, int);
     int       getBlobLength();
+    // the blob's content in place, NULL if it wasn't kept
+    uint8_t *getBlobContent();
     bool      getBoolean();
     osctime_t getTime();
 
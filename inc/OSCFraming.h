@@ -0,0 +1,344 @@
+#pragma once
+
+#include "daisy_core.h"
+#include "OSCMessage.h"
+
+// packet framing for OSC over byte streams such as a UART
+//
+// the decoders split a continuous stream into complete packets and hand each
+// one to a callback, which can decode it in one go with OSCMessage::fill(),
+// OSCMessageView or OSCBundleView
+// the packets are assembled in a buffer supplied by the caller, packets which
+// don't fit are discarded
+
+// called for every complete packet
+// the packet is only valid during the call
+typedef void (*OSCPacketCallback)(uint8_t *packet, int length, void *context);
+
+// called with the length of a packet before any of it is received
+// returning false skips the packet without copying it
+typedef bool (*OSCAcceptCallback)(uint32_t length, void *context);
+
+/*=============================================================================
+    SLIP (OSC 1.1)
+ =============================================================================*/
+
+#define OSC_SLIP_END 0xC0
+#define OSC_SLIP_ESC 0xDB
+#define OSC_SLIP_ESC_END 0xDC
+#define OSC_SLIP_ESC_ESC 0xDD
+
+// the size of the buffer used to escape outgoing packets
+#ifndef OSC_SLIP_CHUNK_SIZE
+#define OSC_SLIP_CHUNK_SIZE 64
+#endif
+
+// writes the SLIP frame of the packet to out, with an END on both sides
+// returns the number of bytes the frame needs
+// nothing is written if that is more than outSize
+size_t oscSlipEncode(const uint8_t *packet,
+                     size_t         length,
+                     uint8_t       *out,
+                     size_t         outSize);
+
+// splits a SLIP stream into packets
+//
+// a corrupted frame is discarded and decoding picks up again at the next
+// END, so a receiver can join the stream at any point
+class OSCSlipDecoder
+{
+    // where the current frame is assembled
+    uint8_t *buffer;
+    size_t   bufferSize;
+    size_t   length;
+
+    // whether the previous byte was an ESC
+    bool escaped;
+
+    // whether the current frame is being discarded
+    bool discarding;
+
+    OSCPacketCallback callback;
+    void             *context;
+
+    // counters
+    uint32_t packetCount;
+    uint32_t errorCount;
+
+    // ends the current frame
+    void endFrame();
+
+  public:
+    OSCSlipDecoder(uint8_t          *_buffer,
+                   size_t            _bufferSize,
+                   OSCPacketCallback _callback,
+                   void             *_context = NULL);
+
+    // feeds bytes from the stream
+    void decode(uint8_t byte);
+    void decode(const uint8_t *bytes, size_t count);
+
+    // discards the frame being assembled
+    void reset();
+
+    // the number of packets passed to the callback
+    uint32_t packets() { return packetCount; }
+
+    // the number of frames discarded for bad escapes or not fitting
+    uint32_t errors() { return errorCount; }
+};
+
+// wraps a transport so that everything sent through it is SLIP framed
+//
+// the escaped bytes are gathered in a small buffer, a message that fits in it
+// goes out in a single transmit call, larger ones in several
+// usage: OSCSlipTransport<daisy::UartHandler> slip(uart); slip.send(msg);
+template <typename T>
+class OSCSlipTransport
+{
+    T &transport;
+
+    // escaped bytes waiting to be transmitted
+    uint8_t chunk[OSC_SLIP_CHUNK_SIZE];
+    size_t  chunkLength;
+
+    void put(uint8_t byte)
+    {
+        if(chunkLength == sizeof(chunk))
+        {
+            flush();
+        }
+        chunk[chunkLength++] = byte;
+    }
+
+    void flush()
+    {
+        if(chunkLength > 0)
+        {
+            transport.BlockingTransmit(chunk, chunkLength);
+            chunkLength = 0;
+        }
+    }
+
+  public:
+    OSCSlipTransport(T &_transport) : transport(_transport), chunkLength(0) {}
+
+    // escapes the bytes of a packet, called by OSCMessage::send()
+    void BlockingTransmit(uint8_t *bytes, size_t count, uint32_t = 100)
+    {
+        while(count--)
+        {
+            uint8_t byte = *bytes++;
+            if(byte == OSC_SLIP_END)
+            {
+                put(OSC_SLIP_ESC);
+                put(OSC_SLIP_ESC_END);
+            }
+            else if(byte == OSC_SLIP_ESC)
+            {
+                put(OSC_SLIP_ESC);
+                put(OSC_SLIP_ESC_ESC);
+            }
+            else
+            {
+                put(byte);
+            }
+        }
+    }
+
+    // sends an OSCMessage or OSCBundle as one frame
+    template <typename P>
+    OSCSlipTransport &send(P &packet)
+    {
+        if(packet.hasError())
+        {
+            return *this;
+        }
+        // the leading END flushes any noise the receiver has buffered
+        put(OSC_SLIP_END);
+        packet.send(*this);
+        put(OSC_SLIP_END);
+        flush();
+        return *this;
+    }
+};
+
+/*=============================================================================
+    LENGTH PREFIX (OSC 1.0 streams)
+ =============================================================================*/
+
+// splits a stream of packets which are each preceded by their size
+// as a 32-bit big-endian integer
+//
+// the size is known before the packet arrives, so a packet is copied
+// straight into place and unwanted or oversized ones are skipped unread
+// a size which is zero or not a multiple of 4 can't be an OSC packet, the
+// decoder then slides forward one byte at a time until it finds a valid one
+class OSCLengthDecoder
+{
+    // where the current packet is assembled
+    uint8_t *buffer;
+    size_t   bufferSize;
+    size_t   length;
+
+    // the size prefix while it is being received
+    uint8_t header[4];
+    int     headerLength;
+
+    // the number of bytes of the current packet still to come
+    uint32_t remaining;
+
+    // whether the current packet is being skipped
+    bool skipping;
+
+    OSCPacketCallback callback;
+    OSCAcceptCallback accept;
+    void             *context;
+
+    // counters
+    uint32_t packetCount;
+    uint32_t skipCount;
+    uint32_t errorCount;
+
+    // called once the size prefix is complete
+    void beginPacket();
+
+  public:
+    // accept may be NULL to take every packet that fits
+    OSCLengthDecoder(uint8_t          *_buffer,
+                     size_t            _bufferSize,
+                     OSCPacketCallback _callback,
+                     OSCAcceptCallback _accept  = NULL,
+                     void             *_context = NULL);
+
+    // feeds bytes from the stream
+    void decode(uint8_t byte);
+    void decode(const uint8_t *bytes, size_t count);
+
+    // discards the packet being assembled and expects a size prefix
+    void reset();
+
+    // the number of packets passed to the callback
+    uint32_t packets() { return packetCount; }
+
+    // the number of packets skipped because they were refused or didn't fit
+    uint32_t skipped() { return skipCount; }
+
+    // the number of invalid size prefixes
+    uint32_t errors() { return errorCount; }
+};
+
+// wraps a transport so that every packet sent through it is preceded by
+// its size
+// usage: OSCLengthTransport<daisy::UartHandler> stream(uart); stream.send(msg);
+template <typename T>
+class OSCLengthTransport
+{
+    T &transport;
+
+  public:
+    OSCLengthTransport(T &_transport) : transport(_transport) {}
+
+    // sends an OSCMessage or OSCBundle with its size
+    template <typename P>
+    OSCLengthTransport &send(P &packet)
+    {
+        if(packet.hasError())
+        {
+            return *this;
+        }
+        // small packets are sent in one go, prefix included
+        uint8_t  buffer[OSC_SEND_BUFFER_SIZE + 4];
+        int      packetSize = packet.encode(buffer + 4, OSC_SEND_BUFFER_SIZE);
+        uint32_t prefix     = BigEndian((uint32_t)packetSize);
+        memcpy(buffer, &prefix, 4);
+        if(packetSize <= OSC_SEND_BUFFER_SIZE)
+        {
+            transport.BlockingTransmit(buffer, packetSize + 4);
+            return *this;
+        }
+        transport.BlockingTransmit(buffer, 4);
+        packet.send(transport);
+        return *this;
+    }
+};
+
+/*=============================================================================
+    STREAM DECODING
+ =============================================================================*/
+
+// called for every complete message
+typedef void (*OSCMessageCallback)(OSCMessage &msg, void *context);
+
+// decodes a stream of length-prefixed messages in place, without
+// assembling the packets first
+//
+// the bytes may arrive in chunks of any size, such as the halves of a
+// circular DMA buffer, the decoder keeps its place between calls
+//   half transfer:  decoder.decode(dmaBuffer, size / 2);
+//   full transfer:  decoder.decode(dmaBuffer + size / 2, size / 2);
+// the address, type tags and fields are assembled in a fixed scratch buffer,
+// so that part of the memory is bounded by the largest of them rather than
+// by the message, and is never reallocated
+// the arguments are still stored as in any OSCMessage, strings and blobs
+// are allocated with oscAlloc(), from the pools when built with OSC_NO_HEAP,
+// unless a blob handler set on getMessage() takes the blobs
+// the size prefix tells where a message ends, it is then complete and
+// handed to the callback
+// bundles, messages with a field too large for the scratch buffer and
+// messages which end early are skipped
+class OSCStreamDecoder
+{
+    OSCMessage message;
+
+    // the size prefix while it is being received
+    uint8_t header[4];
+    int     headerLength;
+
+    // the number of bytes of the current message still to come
+    uint32_t remaining;
+
+    // whether the first byte of the message is still to come
+    bool starting;
+
+    // whether the current message is being skipped
+    bool skipping;
+
+    OSCMessageCallback callback;
+    void              *context;
+
+    // counters
+    uint32_t messageCount;
+    uint32_t skipCount;
+    uint32_t errorCount;
+
+    // called once the size prefix is complete
+    void beginMessage();
+    // called once the last byte of the message has arrived
+    void endMessage();
+
+  public:
+    OSCStreamDecoder(uint8_t           *scratch,
+                     int                scratchSize,
+                     OSCMessageCallback _callback,
+                     void              *_context = NULL);
+
+    // feeds bytes from the stream
+    void decode(uint8_t byte);
+    void decode(const uint8_t *bytes, size_t count);
+
+    // discards the message being decoded and expects a size prefix
+    void reset();
+
+    // the message the stream is decoded into, for setting a blob handler
+    OSCMessage &getMessage() { return message; }
+
+    // the number of messages passed to the callback
+    uint32_t messages() { return messageCount; }
+
+    // the number of bundles and messages which didn't fit
+    uint32_t skipped() { return skipCount; }
+
+    // the number of invalid size prefixes and malformed messages
+    uint32_t errors() { return errorCount; }
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <type_traits>
+
+#include "daisy_core.h"
+
+// FNV-1a hashing of addresses
+//
+// the same function runs at compile time for literal addresses and at run
+// time for received ones, OSCMessage hashes its address once when it is set
+// so handlers can compare a single integer, for example
+//   switch(msg.getAddressHash())
+//   {
+//       case OSC_HASH("/synth/freq"): ...
+//   }
+// equal hashes don't guarantee equal addresses, a hit should be confirmed
+// with a string comparison when collisions matter
+
+#define OSC_HASH_BASIS 2166136261u
+#define OSC_HASH_PRIME 16777619u
+
+// hashes length characters of s, continuing from hash
+constexpr uint32_t
+oscHash(const char *s, int length, uint32_t hash = OSC_HASH_BASIS)
+{
+    while(length-- > 0)
+    {
+        hash = (hash ^ (uint8_t)*s++) * OSC_HASH_PRIME;
+    }
+    return hash;
+}
+
+// hashes a null terminated string
+constexpr uint32_t oscHash(const char *s)
+{
+    uint32_t hash = OSC_HASH_BASIS;
+    while(*s != '\0')
+    {
+        hash = (hash ^ (uint8_t)*s++) * OSC_HASH_PRIME;
+    }
+    return hash;
+}
+
+// the hash of a string literal, guaranteed to be computed at compile time
+#define OSC_HASH(str) (std::integral_constant<uint32_t, oscHash(str)>::value)
@@ -34,6 +34,61 @@ extern "C"
                   int        *pattern_offset,
                   int        *address_offset);
 
+    /**
+   * The number of bytes available for the program of a compiled pattern
+   */
+#ifndef OSC_PATTERN_MAX_CODE
+#define OSC_PATTERN_MAX_CODE 128
+#endif
+
+    /**
+   * The number of [] character classes a compiled pattern can hold
+   */
+#ifndef OSC_PATTERN_MAX_CLASSES
+#define OSC_PATTERN_MAX_CLASSES 4
+#endif
+
+    /**
+   * Address components longer than this never match a compiled pattern
+   */
+#define OSC_PATTERN_MAX_COMPONENT 255
+
+    /**
+   * A pattern compiled once by osc_pattern_compile(), so that matching
+   * does not have to interpret the pattern syntax again.
+   * Literal runs are stored as length-prefixed spans, [] as 256-bit sets
+   * and {} as a table of length-prefixed alternatives.
+   */
+    typedef struct
+    {
+        uint8_t code[OSC_PATTERN_MAX_CODE];
+        uint8_t classes[OSC_PATTERN_MAX_CLASSES][32];
+    } osc_pattern;
+
+    /**
+   * Compile a pattern for osc_pattern_match().
+   *
+   * @param compiled The compiled pattern
+   * @param pattern The pattern to compile
+   * @return 1 if the pattern was compiled, 0 if it is malformed or too large
+   */
+    int osc_pattern_compile(osc_pattern *compiled, const char *pattern);
+
+    /**
+   * Match an address against a compiled pattern, without recursion.
+   * Unlike osc_match(), the address is taken literally and partial matches
+   * are only reported at the end of an address component.
+   *
+   * @param compiled The compiled pattern
+   * @param address The address to match
+   * @param address_offset The number of bytes into the address that were matched successfully
+   * @return 0 if the match failed altogether, or an or'd combination of OSC_MATCH_ADDRESS_COMPLETE and
+   * OSC_MATCH_PATTERN_COMPLETE.
+   */
+    int osc_pattern_match(const osc_pattern *compiled,
+                          const char        *address,
+                          int               *address_offset);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -1,29 +1,81 @@
 #pragma once
 
 #include <string.h>
+#include <new>
 
 #include "daisy_core.h"
 #include "OSCData.h"
 #include "OSCTiming.h"
 #include "OSCMatch.h"
+#include "OSCHash.h"
+#include "OSCProfile.h"
+#include "OSCSegment.h"
 #include "per/uart.h"
 
 using namespace daisy;
 
+// number of arguments stored inside the message itself
+// messages with more arguments move their slots to the heap
+#ifndef OSC_INLINE_ARGS
+#define OSC_INLINE_ARGS 8
+#endif
+#if OSC_INLINE_ARGS < 1
+#error "OSC_INLINE_ARGS must be at least 1"
+#endif
+
+// where the content of a streamed blob goes
+typedef struct
+{
+    // receives the whole content, or NULL to hand it to chunk
+    uint8_t *buffer;
+    // receives the content as it arrives, length bytes at offset
+    void (*chunk)(const uint8_t *bytes,
+                  int            length,
+                  uint32_t       offset,
+                  void          *context);
+    void *context;
+} OSCBlobSink;
+
+// called by fill() once the length of a blob argument is known, the
+// address and the blob's position among the arguments have been decoded
+// return true after setting the sink to take the content, or false to have
+// the message keep it as usual
+typedef bool (*OSCBlobHandler)(const char  *address,
+                               int          position,
+                               uint32_t     length,
+                               OSCBlobSink *sink,
+                               void        *context);
+
 class OSCMessage
 {
-    //  TODO: plug this
-    //  friend class OSCBundle;
+    // bundles encode their messages in place
+    friend class OSCBundle;
+    template <size_t>
+    friend class OSCMessageQueue;
+    // knows where a streamed message ends
+    friend class OSCStreamDecoder;
 
     // the address
     char *address;
 
-    // the data
-    OSCData **data;
+    // worked out once whenever the address is set
+    uint32_t addressHash;
+    int      addressLength;
+    bool     addressPattern;
+
+    // the data, a contiguous array of argument slots
+    // points to inlineData until the message outgrows it
+    OSCData *data;
 
     // the number of OSCData in the data array
     int dataCount;
 
+    // the number of slots available in the data array
+    int dataCapacity;
+
+    // storage for the first OSC_INLINE_ARGS arguments
+    alignas(OSCData) uint8_t inlineData[OSC_INLINE_ARGS * sizeof(OSCData)];
+
     // error codes for potential runtime problems
     OSCErrorCode error;
 
@@ -48,17 +100,40 @@ class OSCMessage
     uint8_t *incomingBuffer;
     int      incomingBufferSize; // how many bytes are stored
     int      incomingBufferFree; // how many bytes are allocated but unused
+    bool     incomingBufferFixed; // whether it belongs to the caller
 
     // adds a byte to the buffer
     void addToIncomingBuffer(uint8_t);
     // clears the incoming buffer
     void clearIncomingBuffer();
 
+    // the position of the argument currently being decoded
+    int decodeIndex;
+
+    // blobs streamed past the incoming buffer, see setBlobHandler()
+    OSCBlobHandler blobHandler;
+    void          *blobHandlerContext;
+    OSCBlobSink    blobSink;
+    uint32_t       blobRemaining; // the bytes still to come
+    uint32_t       blobOffset;    // the bytes handed to the sink
+
     // decoding function
     void decode(uint8_t);
     void decodeAddress();
     void decodeType(uint8_t);
     void decodeData(uint8_t);
+    // moves decodeIndex past the types which carry no data
+    void skipEmptyData();
+    // asks the blob handler for a sink, returns false if there is none
+    bool openBlob(uint32_t length, int position);
+    // hands content of the blob being streamed to its sink
+    void streamBlob(const uint8_t *, int);
+    // hands a blob in a complete packet to a sink or takes a copy
+    void sinkBlob(OSCData *, const char *address, int position);
+
+    // decodes a complete message in one pass
+    // returns the number of bytes consumed, or 0 if the message is partial
+    int decodeBlock(const uint8_t *, int);
 
     /*=============================================================================
   HELPER FUNCTIONS
@@ -66,9 +141,91 @@ class OSCMessage
 
     void setupMessage();
 
+    // writes the wire image at ptr without checking its size
+    // returns the end of the image
+    uint8_t *encodeTo(uint8_t *ptr);
+
+    // writes the wire image to an OSCSegmentWriter, strings and blobs
+    // by reference
+    template <typename W>
+    void writeTo(W &writer)
+    {
+        static const uint8_t comma = ',';
+        int                  addrLen = strlen(address) + 1;
+        writer.reference((const uint8_t *)address, addrLen);
+        writer.zeros(padSize(addrLen));
+
+        writer.copy(&comma, 1);
+        for(int i = 0; i < dataCount; i++)
+        {
+            writer.copy(&data[i].type, 1);
+        }
+        // the type string has to be null terminated
+        writer.zeros(4 - ((dataCount + 1) & 3));
+
+        for(int i = 0; i < dataCount; i++)
+        {
+            OSCData *datum = &data[i];
+            switch(datum->type)
+            {
+                case 's':
+                case 'b':
+                    if(datum->borrowed)
+                    {
+                        // the content doesn't carry its length
+                        uint32_t length = BigEndian((uint32_t)datum->bytes - 4);
+                        writer.copy(&length, 4);
+                        if(datum->data.b != NULL)
+                        {
+                            writer.reference(datum->data.b, datum->bytes - 4);
+                        }
+                        else
+                        {
+                            writer.zeros(datum->bytes - 4);
+                        }
+                    }
+                    else
+                    {
+                        writer.reference(datum->data.b, datum->bytes);
+                    }
+                    writer.zeros(padSize(datum->bytes));
+                    break;
+                case 'd':
+                {
+                    double d = BigEndian(datum->data.d);
+                    writer.copy(&d, 8);
+                }
+                break;
+                case 't':
+                {
+                    osctime_t time = datum->data.time;
+                    uint32_t  t[2] = {BigEndian(time.seconds),
+                                      BigEndian(time.fractionofseconds)};
+                    writer.copy(t, 8);
+                }
+                break;
+                case 'T':
+                case 'F': break;
+                default:
+                { // float or int
+                    uint32_t i = BigEndian(datum->data.i);
+                    writer.copy(&i, datum->bytes);
+                }
+                break;
+            }
+        }
+    }
+
+    // returns the next unused slot of the data array, growing it if needed
+    // returns NULL if the array could not be grown
+    OSCData *reserveSlot();
+
     // compares the OSCData's type char to a test char
     bool testType(int position, char type);
 
+    // messages come from the pools when built with OSC_NO_HEAP
+    OSC_POOL_ALLOCATED
+
   public:
     // returns the OSCData at that position
     OSCData *getOSCData(int);
@@ -88,6 +245,12 @@ class OSCMessage
     // created from another OSCMessage
     OSCMessage(OSCMessage *);
 
+    // the arguments may live inside the message, a copy of its members
+    // would point into the original, so copies go through the constructor
+    // above
+    OSCMessage(const OSCMessage &) = delete;
+    OSCMessage &operator=(const OSCMessage &) = delete;
+
     // DESTRUCTOR
     ~OSCMessage();
 
@@ -102,8 +265,15 @@ class OSCMessage
     template <typename T>
     OSCMessage &add(T datum)
     {
-        // make a piece of data
-        OSCData *d = new OSCData(datum);
+        // get a slot at the end of the data array
+        OSCData *d = reserveSlot();
+        if(d == NULL)
+        {
+            error = ALLOCFAILED;
+            return *this;
+        }
+        // make a piece of data in place
+        new(d) OSCData(datum);
         // check if it has any errors
         if(d->error == ALLOCFAILED)
         {
@@ -111,21 +281,8 @@ class OSCMessage
         }
         else
         {
-            // resize the data array
-            OSCData **dataMem = (OSCData **)realloc(
-                data, sizeof(OSCData *) * (dataCount + 1));
-            if(dataMem == NULL)
-            {
-                error = ALLOCFAILED;
-            }
-            else
-            {
-                data = dataMem;
-                // add data to the end of the array
-                data[dataCount] = d;
-                // increment the data size
-                dataCount++;
-            }
+            // increment the data size
+            dataCount++;
         }
         return *this;
     }
@@ -133,8 +290,15 @@ class OSCMessage
     // blob specific add
     OSCMessage &add(uint8_t *blob, int length)
     {
-        // make a piece of data
-        OSCData *d = new OSCData(blob, length);
+        // get a slot at the end of the data array
+        OSCData *d = reserveSlot();
+        if(d == NULL)
+        {
+            error = ALLOCFAILED;
+            return *this;
+        }
+        // make a piece of data in place
+        new(d) OSCData(blob, length);
         // check if it has any errors
         if(d->error == ALLOCFAILED)
         {
@@ -142,21 +306,8 @@ class OSCMessage
         }
         else
         {
-            // resize the data array
-            OSCData **dataMem = (OSCData **)realloc(
-                data, sizeof(OSCData *) * (dataCount + 1));
-            if(dataMem == NULL)
-            {
-                error = ALLOCFAILED;
-            }
-            else
-            {
-                data = dataMem;
-                // add data to the end of the array
-                data[dataCount] = d;
-                // increment the data size
-                dataCount++;
-            }
+            // increment the data size
+            dataCount++;
         }
         return *this;
     }
@@ -167,22 +318,15 @@ class OSCMessage
     {
         if(position < dataCount)
         {
-            // replace the OSCData with a new one
-            OSCData *oldDatum = getOSCData(position);
-            // destroy the old one
-            delete oldDatum;
-            // make a new one
-            OSCData *newDatum = new OSCData(datum);
+            // destroy the old data
+            data[position].~OSCData();
+            // make a new one in the same slot
+            new(&data[position]) OSCData(datum);
             // test if there was an error
-            if(newDatum->error == ALLOCFAILED)
+            if(data[position].error == ALLOCFAILED)
             {
                 error = ALLOCFAILED;
             }
-            else
-            {
-                // otherwise, put it in the data array
-                data[position] = newDatum;
-            }
         }
         else if(position == (dataCount))
         {
@@ -202,22 +346,15 @@ class OSCMessage
     {
         if(position < dataCount)
         {
-            // replace the OSCData with a new one
-            OSCData *oldDatum = getOSCData(position);
-            // destroy the old one
-            delete oldDatum;
-            // make a new one
-            OSCData *newDatum = new OSCData(blob, length);
+            // destroy the old data
+            data[position].~OSCData();
+            // make a new one in the same slot
+            new(&data[position]) OSCData(blob, length);
             // test if there was an error
-            if(newDatum->error == ALLOCFAILED)
+            if(data[position].error == ALLOCFAILED)
             {
                 error = ALLOCFAILED;
             }
-            else
-            {
-                // otherwise, put it in the data array
-                data[position] = newDatum;
-            }
         }
         else if(position == (dataCount))
         {
@@ -273,6 +410,17 @@ class OSCMessage
     // put the address in the buffer
     int getAddress(char *buffer, int offset = 0);
     int getAddress(char *buffer, int offset, int len);
+    // returns the address without copying it
+    const char *getAddress() { return address; }
+
+    // the hash of the address, see OSCHash.h
+    uint32_t getAddressHash() { return addressHash; }
+
+    // the length of the address
+    int getAddressLength() { return addressLength; }
+
+    // whether the address uses the pattern syntax
+    bool isAddressPattern() { return addressPattern; }
 
     /*=============================================================================
     TESTING DATA
@@ -309,6 +457,22 @@ class OSCMessage
     bool
     route(const char *pattern, void (*callback)(OSCMessage &, int), int = 0);
 
+    // the same against a pattern compiled by osc_pattern_compile(), with the
+    // roles reversed: the overloads above take the message's address as the
+    // pattern and honour only * in the string they are given, these take
+    // the compiled string as the pattern and the address literally
+    // so a compiled "/synth/*" matches an incoming "/synth/freq", while
+    // dispatch("/synth/*") matches it only through its *, and an incoming
+    // "/synth/*" matches dispatch("/synth/freq") but not the compiled
+    // "/synth/freq"
+    bool fullMatch(const osc_pattern *pattern, int = 0);
+    int  match(const osc_pattern *pattern, int = 0);
+    bool
+    dispatch(const osc_pattern *pattern, void (*callback)(OSCMessage &), int = 0);
+    bool route(const osc_pattern *pattern,
+               void (*callback)(OSCMessage &, int),
+               int = 0);
+
     /*=============================================================================
     SIZE
   =============================================================================*/
@@ -325,95 +489,81 @@ class OSCMessage
       TRANSMISSION
    =============================================================================*/
 
-    // send the message
+    // writes the message's wire image to the buffer in one pass
+    // returns the number of bytes the message needs
+    // nothing is written if that is more than bufferSize
+    // returns 0 for a message with errors
+    int encode(uint8_t *buffer, size_t bufferSize);
+
+    // send the message with a single transmit call
+    // using the passed buffer to hold the wire image
     template <typename T>
-    OSCMessage &send(T &p)
+    OSCMessage &send(T &p, uint8_t *buffer, size_t bufferSize)
     {
+        OSC_PROFILE_STAGE(OSC_STAGE_SEND);
         // don't send a message with errors
         if(hasError())
         {
             return *this;
         }
-        uint8_t nullChar = '\0';
-
-        // send the address
-        int addrLen = strlen(address) + 1;
-        // padding amount
-        int addrPad = padSize(addrLen);
-        // write it to the stream
-        p.BlockingTransmit((uint8_t *)address, addrLen);
-
-        // add the padding
-        while(addrPad--)
+        int messageSize = encode(buffer, bufferSize);
+        if((size_t)messageSize > bufferSize)
         {
-            p.BlockingTransmit(&nullChar, 1);
-        }
-        // add the comma separator
-        p.BlockingTransmit((uint8_t *)',', 1);
-
-        // add the types
-        for(int i = 0; i < dataCount; i++)
-        {
-            uint8_t t = getType(i);
-            p.BlockingTransmit(&t, 1);
+            error = BUFFER_FULL;
+            return *this;
         }
+        p.BlockingTransmit(buffer, messageSize);
+        return *this;
+    }
 
-        // pad the types
-        int typePad = padSize(dataCount + 1); // 1 is for the comma
-        if(typePad == 0)
+    // send the message, with a single transmit call when it is small
+    // see OSCSegment.h for the transports it works with
+    template <typename T>
+    OSCMessage &send(T &p)
+    {
+        OSC_PROFILE_STAGE(OSC_STAGE_SEND);
+        // don't send a message with errors
+        if(hasError())
         {
-            typePad
-                = 4; // This is because the type string has to be null terminated
+            return *this;
         }
-        while(typePad--)
+        OSCSegmentWriter<T> writer(p);
+        // small messages are encoded in one go
+        if(!writer.encode(*this))
         {
-            p.BlockingTransmit(&nullChar, 1);
-        }
-
-        // write the data
-        for(int i = 0; i < dataCount; i++)
-        {
-            OSCData *datum = getOSCData(i);
-            if((datum->type == 's') || (datum->type == 'b'))
-            {
-                p.BlockingTransmit(datum->data.b, datum->bytes);
-                int dataPad = padSize(datum->bytes);
-                while(dataPad--)
-                {
-                    p.BlockingTransmit(&nullChar, 1);
-                }
-            }
-            else if(datum->type == 'd')
-            {
-                double   d   = BigEndian(datum->data.d);
-                uint8_t *ptr = (uint8_t *)&d;
-                p.BlockingTransmit(ptr, 8);
-            }
-            else if(datum->type == 't')
-            {
-                osctime_t time = datum->data.time;
-                uint32_t  d    = BigEndian(time.seconds);
-                uint8_t  *ptr  = (uint8_t *)&d;
-                p.BlockingTransmit(ptr, 4);
-                d   = BigEndian(time.fractionofseconds);
-                ptr = (uint8_t *)&d;
-                p.BlockingTransmit(ptr, 4);
-            }
-            else if(datum->type == 'T' || datum->type == 'F') {}
-            else
-            { // float or int
-                uint32_t i   = BigEndian(datum->data.i);
-                uint8_t *ptr = (uint8_t *)&i;
-                p.BlockingTransmit(ptr, datum->bytes);
-            }
+            writeTo(writer);
         }
+        writer.flush();
         return *this;
     }
 
     // fill the message from a byte stream
     OSCMessage &fill(uint8_t);
+    // a complete message is decoded in one pass,
+    // partial input goes through the byte by byte decoder
     OSCMessage &fill(uint8_t *, int);
 
+    // streams received blobs to a sink chosen per blob, so that their
+    // content is written once, straight to where it's used, without
+    // growing the incoming buffer or copying it into the message
+    // the message then holds blobs which borrow the sink's buffer, or no
+    // content at all with a chunk callback, they encode as zeros
+    // a chunk callback receives whatever arrived in one fill() call
+    // the handler stays set when the message is emptied
+    void setBlobHandler(OSCBlobHandler handler, void *context = NULL);
+
+    // decodes byte streams with a fixed buffer of size bytes instead of
+    // growing one on the heap, it must hold the largest address, type tags
+    // or string, a field which doesn't fit sets BUFFER_FULL
+    // blobs don't go through it, their content goes to a sink or straight
+    // into their own allocation, made once its length is known
+    // if that allocation fails the content is dropped and the message gets
+    // ALLOCFAILED, so check hasError() before handling a message decoded
+    // this way, OSCStreamDecoder, OSCMessageQueue and OSCRouter skip it
+    // the buffer stays set when the message is emptied, NULL goes back to
+    // the heap
+    void setIncomingBuffer(uint8_t *buffer, int size);
+
     /*=============================================================================
     ERROR
   =============================================================================*/
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <atomic>
+
+#include "daisy_core.h"
+#include "OSCMessage.h"
+
+// what happens to a message that arrives while the queue is full
+typedef enum
+{
+    OSC_DROP_NEWEST = 0, // discard the incoming message
+    OSC_DROP_OLDEST,     // discard the oldest queued message to make room
+} OSCOverflowPolicy;
+
+// hands decoded messages from the receive interrupt to the main loop
+//
+// the queue owns Capacity preallocated messages, the producer (the UART or
+// DMA callback) decodes straight into a free one and publishes it, the
+// consumer (the main loop or the audio callback) reads it in place and
+// releases it, nothing is copied and neither side disables interrupts
+// there must be exactly one producer and one consumer
+//
+// with OSC_DROP_OLDEST the producer takes the oldest message back from the
+// consumer, unless the consumer is reading it, then the newest is dropped
+//
+// decoding string and blob arguments allocates, build with OSC_NO_HEAP to
+// have that served by the pools from inside an interrupt
+// released messages are emptied by the consumer, so what a message
+// allocated is freed outside the interrupt unless the producer drops it
+template <size_t Capacity>
+class OSCMessageQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "OSCMessageQueue capacity must be a power of two");
+
+    // set in tail while the consumer reads the oldest message
+    static const uint32_t BUSY = 0x80000000u;
+
+    OSCMessage slots[Capacity];
+
+    // the number of published messages, only written by the producer
+    std::atomic<uint32_t> head;
+
+    // the number of released messages, with the BUSY flag
+    // written by the consumer, and by the producer when dropping the oldest
+    std::atomic<uint32_t> tail;
+
+    OSCOverflowPolicy overflowPolicy;
+
+    // whether the producer holds a reserved slot
+    bool reserved;
+
+    // counters
+    std::atomic<uint32_t> pushCount;
+    std::atomic<uint32_t> dropCount;
+
+    // the distance between two counters, which wrap below BUSY
+    static uint32_t distance(uint32_t from, uint32_t to)
+    {
+        return (to - from) & ~BUSY;
+    }
+
+    // readies a slot for decoding
+    // it stays invalid until an address was decoded, like a new message
+    // slots the consumer released were emptied by release(), so this doesn't
+    // touch the heap, only slots the producer filled itself (an unpublished
+    // reservation, a discarded message or the dropped oldest one) are
+    // emptied here, freeing what decoding them allocated
+    static OSCMessage *clear(OSCMessage &msg)
+    {
+        if(msg.dataCount > 0 || msg.incomingBufferSize > 0
+           || msg.decodeState != OSCMessage::STANDBY)
+        {
+            msg.empty();
+        }
+        msg.error = INVALID_OSC;
+        return &msg;
+    }
+
+  public:
+    OSCMessageQueue(OSCOverflowPolicy _overflowPolicy = OSC_DROP_NEWEST)
+    : head(0),
+      tail(0),
+      overflowPolicy(_overflowPolicy),
+      reserved(false),
+      pushCount(0),
+      dropCount(0)
+    {
+    }
+
+    /*=============================================================================
+      PRODUCER
+    =============================================================================*/
+
+    // returns an empty message to decode the next packet into
+    // returns NULL if the queue is full and the incoming message is dropped
+    OSCMessage *reserve()
+    {
+        uint32_t last = head.load(std::memory_order_relaxed);
+        if(reserved)
+        {
+            // the previous reservation was never published, reuse it
+            return clear(slots[last % Capacity]);
+        }
+        uint32_t first = tail.load(std::memory_order_acquire);
+        if(distance(first, last) == Capacity)
+        {
+            // only succeeds if the consumer isn't reading the oldest message
+            if(overflowPolicy == OSC_DROP_NEWEST || (first & BUSY)
+               || !tail.compare_exchange_strong(first,
+                                                (first + 1) & ~BUSY,
+                                                std::memory_order_acq_rel))
+            {
+                dropCount.fetch_add(1, std::memory_order_relaxed);
+                return NULL;
+            }
+            dropCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        reserved = true;
+        return clear(slots[last % Capacity]);
+    }
+
+    // makes the reserved message visible to the consumer
+    // messages with errors are discarded instead
+    void publish()
+    {
+        if(!reserved)
+        {
+            return;
+        }
+        reserved      = false;
+        uint32_t last = head.load(std::memory_order_relaxed);
+        if(slots[last % Capacity].hasError())
+        {
+            dropCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        pushCount.fetch_add(1, std::memory_order_relaxed);
+        head.store((last + 1) & ~BUSY, std::memory_order_release);
+    }
+
+    // decodes a complete packet into the queue
+    // returns false if it was dropped or could not be decoded
+    bool push(uint8_t *packet, int length)
+    {
+        OSCMessage *msg = reserve();
+        if(msg == NULL)
+        {
+            return false;
+        }
+        msg->fill(packet, length);
+        bool decoded = !msg->hasError();
+        publish();
+        return decoded;
+    }
+
+    /*=============================================================================
+      CONSUMER
+    =============================================================================*/
+
+    // returns the oldest message, which stays valid until release()
+    // returns NULL if the queue is empty
+    OSCMessage *peek()
+    {
+        uint32_t first = tail.load(std::memory_order_acquire);
+        while(true)
+        {
+            if(first & BUSY)
+            {
+                // still reading the previous peek
+                return &slots[(first & ~BUSY) % Capacity];
+            }
+            if(first == head.load(std::memory_order_acquire))
+            {
+                return NULL;
+            }
+            // claim the message so that the producer can't drop it
+            if(tail.compare_exchange_weak(
+                   first, first | BUSY, std::memory_order_acq_rel))
+            {
+                return &slots[first % Capacity];
+            }
+        }
+    }
+
+    // hands the message returned by peek() back to the producer
+    // the message is emptied here, on the consumer's side, so that the
+    // producer can reuse the slot without freeing anything
+    void release()
+    {
+        uint32_t first = tail.load(std::memory_order_relaxed);
+        if(first & BUSY)
+        {
+            slots[(first & ~BUSY) % Capacity].empty();
+            // the producer never moves tail while it's busy
+            tail.store(((first & ~BUSY) + 1) & ~BUSY,
+                       std::memory_order_release);
+        }
+    }
+
+    // calls the function for every queued message, releasing them
+    // returns the number of messages
+    int drain(void (*callback)(OSCMessage &))
+    {
+        int         count = 0;
+        OSCMessage *msg;
+        while((msg = peek()) != NULL)
+        {
+            callback(*msg);
+            release();
+            count++;
+        }
+        return count;
+    }
+
+    /*=============================================================================
+      STATUS
+    =============================================================================*/
+
+    // the number of queued messages
+    size_t size()
+    {
+        return distance(tail.load(std::memory_order_acquire),
+                        head.load(std::memory_order_acquire));
+    }
+
+    // the number of messages published since the start
+    uint32_t pushed() { return pushCount.load(std::memory_order_relaxed); }
+
+    // the number of messages lost to overflow or decoding errors
+    uint32_t dropped() { return dropCount.load(std::memory_order_relaxed); }
+};
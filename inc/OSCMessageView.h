@@ -0,0 +1,153 @@
+#pragma once
+
+#include <string.h>
+
+#include "daisy_core.h"
+#include "OSCData.h"
+#include "OSCTiming.h"
+#include "OSCMatch.h"
+
+// the maximum number of arguments a view can index
+#ifndef OSC_VIEW_MAX_ARGS
+#define OSC_VIEW_MAX_ARGS 16
+#endif
+
+// read-only view of a complete OSC message sitting in a receive buffer
+// the packet is validated once and nothing is copied,
+// arguments are byte-swapped when they are read
+// the buffer must outlive the view
+class OSCMessageView
+{
+    // the packet
+    const uint8_t *buffer;
+
+    // the number of bytes the message occupies in the buffer
+    int length;
+
+    // the type tags, without the leading comma
+    const char *types;
+
+    // the number of arguments
+    int dataCount;
+
+    // the offset of each argument from the start of the buffer
+    int offsets[OSC_VIEW_MAX_ARGS];
+
+    // error codes for potential runtime problems
+    OSCErrorCode error;
+
+    /*=============================================================================
+    HELPER FUNCTIONS
+  =============================================================================*/
+
+    // returns the start of the argument if it exists and has the right type
+    const uint8_t *argument(int position, char type);
+
+    // compares the argument's type char to a test char
+    bool testType(int position, char type);
+
+  public:
+    /*=============================================================================
+    CONSTRUCTORS
+  =============================================================================*/
+
+    // an empty view, invalid until parse() succeeds
+    OSCMessageView();
+    // parses the packet right away
+    OSCMessageView(const uint8_t *packet, int packetLength);
+
+    // validates the packet and records the offsets of its fields
+    // trailing bytes after the last argument are not part of the message
+    OSCErrorCode parse(const uint8_t *packet, int packetLength);
+
+    /*=============================================================================
+    GETTING DATA
+
+    getters take a position as an argument
+  =============================================================================*/
+
+    int32_t   getInt(int);
+    osctime_t getTime(int);
+
+    float  getFloat(int);
+    double getDouble(int);
+    bool   getBoolean(int);
+
+    // returns the string inside the packet, NULL if it's not a string
+    const char *getString(int);
+    // copies the string into the buffer, returns the copied length with the terminator
+    int getString(int, char *, int);
+
+    // returns the blob's content inside the packet, NULL if it's not a blob
+    const uint8_t *getBlob(int);
+    // copies the blob into the buffer, returns the copied length
+    int getBlob(int, uint8_t *, int);
+
+    // returns the length of blob
+    uint32_t getBlobLength(int position);
+
+    // returns the number of bytes of the data at that position, including blob headers
+    int getDataLength(int);
+
+    // returns the type at the position
+    char getType(int);
+
+    // returns the type tags, without the comma
+    const char *getTypes() { return types; }
+
+    // returns the address inside the packet
+    const char *getAddress() { return (const char *)buffer; }
+
+    /*=============================================================================
+    TESTING DATA
+
+    testers take a position as an argument
+  =============================================================================*/
+
+    bool isInt(int);
+    bool isFloat(int);
+    bool isBlob(int);
+    bool isChar(int);
+    bool isString(int);
+    bool isDouble(int);
+    bool isBoolean(int);
+    bool isTime(int);
+
+    /*=============================================================================
+    PATTERN MATCHING
+  =============================================================================*/
+
+    // match the pattern against the address
+    // returns true only for a complete match
+    bool fullMatch(const char *pattern, int = 0);
+
+    // returns the number of characters matched in the address
+    int match(const char *pattern, int = 0);
+
+    // calls the function with the view as the arg if it was a full match
+    bool
+    dispatch(const char *pattern, void (*callback)(OSCMessageView &), int = 0);
+
+    // like dispatch, but allows for partial matches
+    // the address match offset is sent as an argument to the callback
+    bool route(const char *pattern,
+               void (*callback)(OSCMessageView &, int),
+               int = 0);
+
+    /*=============================================================================
+    SIZE
+  =============================================================================*/
+
+    // the number of data that the message contains
+    int size() { return dataCount; }
+
+    // the number of bytes the message occupies in the packet
+    int bytes() { return length; }
+
+    /*=============================================================================
+    ERROR
+  =============================================================================*/
+
+    bool         hasError() { return error != OSC_OK; }
+    OSCErrorCode getError() { return error; }
+};
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <atomic>
+#include <string.h>
+
+#include "daisy_core.h"
+#include "OSCHash.h"
+#include "OSCMessage.h"
+
+// how an incoming value is turned into the parameter's value
+typedef enum
+{
+    OSC_SCALE_NONE = 0,    // the value as it is, clamped to the range
+    OSC_SCALE_LINEAR,      // 0 to 1 mapped linearly onto the range
+    OSC_SCALE_EXPONENTIAL, // 0 to 1 mapped exponentially, for frequencies
+                           // and times, the range must be above 0
+} OSCScaling;
+
+// how the audio thread follows a change of a float parameter
+typedef enum
+{
+    OSC_SMOOTH_NONE = 0, // jumps to the new value
+    OSC_SMOOTH_ONE_POLE, // approaches it with a time constant
+    OSC_SMOOTH_LINEAR,   // ramps to it in a fixed time
+} OSCSmoothing;
+
+// a value set by OSC messages and read by the audio callback
+//
+// the main loop publishes the value with a single atomic store, the audio
+// callback reads it with a single atomic load, so neither side waits and
+// a value is never seen half written
+// get() and getInt() return the published value, next() advances the
+// smoother by one sample and must only be called from the audio callback
+class OSCParameter
+{
+    template <size_t>
+    friend class OSCParameters;
+
+    // published by the main loop
+    std::atomic<float>   value;
+    std::atomic<int32_t> intValue;
+
+    // the binding, only used by the main loop
+    const char *address;
+    uint32_t    hash;
+    int         length;
+    bool        integer;
+    float       min;
+    float       max;
+    OSCScaling  scaling;
+
+    // the smoother, only used by the audio callback
+    OSCSmoothing smoothing;
+    int          smoothingSamples;
+    float        coefficient; // one pole
+    float        current;
+    float        rampTarget; // linear
+    float        rampStep;
+    int          rampRemaining;
+
+    void bind(const char *_address, bool _integer, float _min, float _max);
+
+  public:
+    // the published value
+    float   get() const { return value.load(std::memory_order_relaxed); }
+    int32_t getInt() const { return intValue.load(std::memory_order_relaxed); }
+
+    // the smoothed value, advanced by one sample
+    float next()
+    {
+        float target = get();
+        switch(smoothing)
+        {
+            case OSC_SMOOTH_ONE_POLE:
+                current += coefficient * (target - current);
+                return current;
+            case OSC_SMOOTH_LINEAR:
+                if(target != rampTarget)
+                {
+                    rampTarget    = target;
+                    rampStep      = (target - current) / smoothingSamples;
+                    rampRemaining = smoothingSamples;
+                }
+                if(rampRemaining > 0)
+                {
+                    // the last step lands on the target exactly
+                    current = --rampRemaining > 0 ? current + rampStep
+                                                  : rampTarget;
+                }
+                return current;
+            default: return target;
+        }
+    }
+
+    // sets how next() follows changes, over about that many samples
+    // call before the audio callback starts
+    OSCParameter &smooth(OSCSmoothing smoothing, int samples);
+
+    // sets how incoming values are scaled, OSC_SCALE_NONE by default
+    OSCParameter &scale(OSCScaling scaling);
+
+    // publishes a value as it would arrive in a message, scaled and
+    // clamped to the range
+    void set(float incoming);
+
+    // the bound address
+    const char *getAddress() const { return address; }
+
+    // whether the parameter holds an int
+    bool isInt() const { return integer; }
+};
+
+// a table of parameters bound to addresses
+//
+//   OSCParameters<32> params;
+//   OSCParameter *cutoff = params.bind("/filter/cutoff", 20, 20000);
+//   cutoff->scale(OSC_SCALE_EXPONENTIAL).smooth(OSC_SMOOTH_ONE_POLE, 480);
+//   in the main loop, for every received message:
+//       params.dispatch(msg);
+//   in the audio callback, for every sample:
+//       float f = cutoff->next();
+//
+// messages with a single int, float, double or boolean argument set every
+// parameter whose address they match, the parameters are kept in one
+// array which dispatch() walks comparing address hashes
+// the addresses are not copied and must outlive the table
+// binding isn't safe once the audio callback runs
+template <size_t Capacity>
+class OSCParameters
+{
+    OSCParameter parameters[Capacity];
+    int          count;
+
+    OSCParameter *add(const char *address, bool integer, float min, float max)
+    {
+        if(count == (int)Capacity)
+        {
+            return NULL;
+        }
+        OSCParameter *parameter = &parameters[count++];
+        parameter->bind(address, integer, min, max);
+        return parameter;
+    }
+
+  public:
+    OSCParameters() : count(0) {}
+
+    // binds a float parameter with that range, starting at min
+    // returns NULL once Capacity parameters are bound
+    OSCParameter *bind(const char *address, float min, float max)
+    {
+        return add(address, false, min, max);
+    }
+
+    // binds an int parameter with that range, starting at min
+    // returns NULL once Capacity parameters are bound
+    OSCParameter *bindInt(const char *address, int32_t min, int32_t max)
+    {
+        return add(address, true, (float)min, (float)max);
+    }
+
+    // sets the parameters the message's address matches
+    // a pattern address is matched against every parameter
+    // returns the number of parameters set
+    int dispatch(OSCMessage &msg)
+    {
+        float incoming;
+        if(msg.size() != 1)
+        {
+            return 0;
+        }
+        switch(msg.getType(0))
+        {
+            case 'i': incoming = (float)msg.getInt(0); break;
+            case 'f': incoming = msg.getFloat(0); break;
+            case 'd': incoming = (float)msg.getDouble(0); break;
+            case 'T':
+            case 'F': incoming = msg.getBoolean(0) ? 1.0f : 0.0f; break;
+            default: return 0;
+        }
+        int set = 0;
+        if(msg.isAddressPattern())
+        {
+            for(int i = 0; i < count; i++)
+            {
+                if(msg.fullMatch(parameters[i].address))
+                {
+                    parameters[i].set(incoming);
+                    set++;
+                }
+            }
+            return set;
+        }
+        uint32_t    hash    = msg.getAddressHash();
+        int         length  = msg.getAddressLength();
+        const char *address = msg.getAddress();
+        for(int i = 0; i < count; i++)
+        {
+            OSCParameter &p = parameters[i];
+            if(p.hash == hash && p.length == length
+               && memcmp(p.address, address, length) == 0)
+            {
+                p.set(incoming);
+                set++;
+            }
+        }
+        return set;
+    }
+
+    // the parameter bound to the address, NULL if there is none
+    OSCParameter *find(const char *address)
+    {
+        uint32_t hash = oscHash(address);
+        for(int i = 0; i < count; i++)
+        {
+            if(parameters[i].hash == hash
+               && strcmp(parameters[i].address, address) == 0)
+            {
+                return &parameters[i];
+            }
+        }
+        return NULL;
+    }
+
+    // the bound parameters, in the order they were bound
+    OSCParameter *begin() { return parameters; }
+    OSCParameter *end() { return parameters + count; }
+
+    // the number of bound parameters
+    int size() { return count; }
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "daisy_core.h"
+
+// memory used by messages, argument slots, addresses and payloads, and by
+// the tables of OSCRouter
+//
+// by default this is the heap
+// when OSC_NO_HEAP is defined it comes from fixed-size block pools instead,
+// so that allocating has a bounded cost and can be done from an interrupt
+// the pools live in one static arena, which can be placed in a chosen
+// memory region by defining OSC_POOL_MEM_SECTION, for example
+//   -DOSC_POOL_MEM_SECTION='__attribute__((section(".sdram_bss")))'
+// exhausting a pool makes the allocation fail, which the library reports
+// as ALLOCFAILED
+
+#ifdef OSC_NO_HEAP
+
+// the number of blocks in each pool
+#ifndef OSC_POOL_BLOCKS_32
+#define OSC_POOL_BLOCKS_32 64
+#endif
+#ifndef OSC_POOL_BLOCKS_64
+#define OSC_POOL_BLOCKS_64 32
+#endif
+#ifndef OSC_POOL_BLOCKS_256
+#define OSC_POOL_BLOCKS_256 16
+#endif
+#ifndef OSC_POOL_BLOCKS_1024
+#define OSC_POOL_BLOCKS_1024 4
+#endif
+
+#ifndef OSC_POOL_MEM_SECTION
+#define OSC_POOL_MEM_SECTION
+#endif
+
+// the number of pools
+#define OSC_POOL_CLASSES 4
+
+// usage of one pool
+typedef struct
+{
+    size_t   blockSize; // the size of each block in bytes
+    size_t   blocks;    // the number of blocks in the pool
+    size_t   used;      // the number of blocks currently allocated
+    size_t   highWater; // the highest number of blocks allocated at once
+    uint32_t failures;  // the number of requests the pool could not serve
+} OSCPoolStats;
+
+// fills stats for the pool at that index, smallest blocks first
+// returns false if there is no such pool
+bool oscPoolGetStats(int pool, OSCPoolStats *stats);
+
+// forgets the high-water marks and failure counts
+void oscPoolResetStats();
+
+void *oscAlloc(size_t size);
+void *oscRealloc(void *ptr, size_t size);
+void  oscFree(void *ptr);
+
+// makes a class allocate its instances from the pools
+#define OSC_POOL_ALLOCATED                                       \
+  public:                                                        \
+    static void *operator new(size_t size) noexcept              \
+    {                                                            \
+        return oscAlloc(size);                                   \
+    }                                                            \
+    static void operator delete(void *ptr) noexcept { oscFree(ptr); }
+
+#else
+
+static inline void *oscAlloc(size_t size)
+{
+    return malloc(size);
+}
+
+static inline void *oscRealloc(void *ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static inline void oscFree(void *ptr)
+{
+    free(ptr);
+}
+
+#define OSC_POOL_ALLOCATED
+
+#endif
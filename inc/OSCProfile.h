@@ -0,0 +1,157 @@
+#pragma once
+
+#include "daisy_core.h"
+
+// timing of the library's hot paths
+//
+// when OSC_PROFILE is defined, decoding, matching, dispatching and sending
+// record how long they take, along with every route of an OSCRouter, which
+// looks up its statistics once when the route is added
+// dispatch() and route() of a message only count towards the stages
+// the times are cycles of the DWT cycle counter on the target and
+// nanoseconds of the monotonic clock on the host (OSC_HOST)
+// without OSC_PROFILE the instrumentation compiles to nothing
+//
+// the statistics can be read with oscProfileGetStage() and
+// oscProfileGetRoute(), or remotely by sending a message to /_osc/stats,
+// see oscProfileReply()
+// measurements are recorded inside a critical section, so stages measured
+// in an interrupt and in the main loop don't corrupt each other, the
+// statistics returned by the getters can still change while being read,
+// oscProfileReply() copies each one inside a critical section
+
+class OSCMessage;
+class OSCBundle;
+
+// the address which asks for the statistics
+#define OSC_PROFILE_ADDRESS "/_osc/stats"
+
+// the number of histogram buckets, bucket i counts the times of
+// 2^i to 2^(i + 1) - 1 units, the last one everything longer
+#define OSC_PROFILE_BUCKETS 16
+
+// the number of routes that are tracked, the first ones added win
+#ifndef OSC_PROFILE_ROUTES
+#define OSC_PROFILE_ROUTES 16
+#endif
+
+// the number of characters kept of each route's address
+#define OSC_PROFILE_NAME_SIZE 32
+
+// the measured stages
+typedef enum
+{
+    OSC_STAGE_DECODE = 0, // fill(), byte by byte or a whole packet
+    OSC_STAGE_DECODE_DATA, // decoding the bytes of an argument
+    OSC_STAGE_MATCH,       // matching an address against a pattern
+    OSC_STAGE_DISPATCH,    // dispatch() and route(), handlers included
+    OSC_STAGE_SEND,        // send()
+    OSC_STAGE_COUNT
+} OSCProfileStage;
+
+typedef struct
+{
+    uint32_t count; // the number of measurements
+    uint32_t min;
+    uint32_t max;
+    uint64_t total; // the sum of all measurements
+    uint32_t histogram[OSC_PROFILE_BUCKETS];
+} OSCProfileStats;
+
+// the average of the measurements
+static inline uint32_t oscProfileMean(const OSCProfileStats *stats)
+{
+    return stats->count > 0 ? (uint32_t)(stats->total / stats->count) : 0;
+}
+
+#ifdef OSC_PROFILE
+
+// starts the cycle counter, call once at startup on the target
+void oscProfileInit();
+
+// forgets every measurement
+void oscProfileReset();
+
+// the statistics of a stage
+const OSCProfileStats *oscProfileGetStage(OSCProfileStage stage);
+
+// the name of a stage, as used in the /_osc/stats replies
+const char *oscProfileStageName(OSCProfileStage stage);
+
+// the number of routes with statistics
+int oscProfileRouteCount();
+
+// the statistics and the address of the route at that index
+// returns NULL if there is no such route
+const OSCProfileStats *oscProfileGetRoute(int index, const char **address);
+
+// answers a message sent to /_osc/stats by adding the statistics to the
+// bundle, one /_osc/stats/<stage> message per stage and one
+// /_osc/stats/route message per route, each with the count, min, max and
+// mean as ints and the histogram as a blob of big-endian ints
+// the route messages start with the route's address
+// returns false, leaving the bundle alone, for any other message, and
+// false if the bundle ran out of memory
+bool oscProfileReply(OSCMessage &request, OSCBundle &reply);
+
+// the statistics of a stage for recording
+OSCProfileStats *oscProfileStage(OSCProfileStage stage);
+
+// the statistics of the route with that address, added if needed
+// returns NULL once OSC_PROFILE_ROUTES routes are tracked
+// looks the address up by hash and comparison, call it once per route and
+// keep the result, and not from an interrupt
+OSCProfileStats *oscProfileRoute(const char *address);
+
+// adds a measurement
+void oscProfileRecord(OSCProfileStats *stats, uint32_t elapsed);
+
+// the current time in profiling units
+#ifdef OSC_HOST
+uint32_t oscProfileNow();
+#else
+static inline uint32_t oscProfileNow()
+{
+    // DWT->CYCCNT
+    return *(volatile uint32_t *)0xE0001004;
+}
+#endif
+
+// measures the lifetime of the scope
+class OSCProfileScope
+{
+    OSCProfileStats *stats;
+    uint32_t         start;
+
+  public:
+    OSCProfileScope(OSCProfileStats *_stats)
+    : stats(_stats), start(oscProfileNow())
+    {
+    }
+    ~OSCProfileScope()
+    {
+        if(stats != NULL)
+        {
+            oscProfileRecord(stats, oscProfileNow() - start);
+        }
+    }
+};
+
+// measures the rest of the enclosing scope
+#define OSC_PROFILE_STAGE(stage) \
+    OSCProfileScope oscProfileStageScope(oscProfileStage(stage))
+#define OSC_PROFILE_ROUTE(stats) OSCProfileScope oscProfileRouteScope(stats)
+
+#else
+
+static inline void oscProfileInit() {}
+static inline void oscProfileReset() {}
+static inline bool oscProfileReply(OSCMessage &, OSCBundle &)
+{
+    return false;
+}
+
+#define OSC_PROFILE_STAGE(stage)
+#define OSC_PROFILE_ROUTE(stats)
+
+#endif
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "daisy_core.h"
+#include "OSCMessage.h"
+
+// a table of routes which dispatches a message to every matching handler
+// in a single walk of its address
+//
+// the registered addresses are split into components and stored in a
+// prefix tree, so the cost of dispatching grows with the depth of the
+// address rather than with the number of routes
+// matching follows OSCMessage::dispatch() and route(): the incoming address
+// may use the OSC pattern syntax and registered components may use '*'
+//
+// full-match routes without a '*' are kept apart in a hash table keyed by the
+// whole address, a literal incoming address finds them with one lookup and
+// one memcmp, using the hash OSCMessage computed when its address was set
+// these routes are called before the ones in the tree
+//
+// the tables come from oscAlloc(), with OSC_NO_HEAP each one must fit in the
+// largest pool block, which bounds the number of routes, addRoute() fails
+// with ALLOCFAILED beyond that
+class OSCRouter
+{
+    // one component of the registered addresses
+    struct Node
+    {
+        uint32_t hash;        // hash of the component
+        int      name;        // offset of the component in names
+        int      length;      // length of the component
+        bool     star;        // whether the component contains a '*'
+        int      firstChild;  // index of the first child, -1 if none
+        int      nextSibling; // index of the next sibling, -1 if none
+        int      handler;     // index of the first handler, -1 if none
+    };
+
+    // a callback registered on a node
+    struct Handler
+    {
+        void (*dispatch)(OSCMessage &);      // called on a full match
+        void (*route)(OSCMessage &, int);    // called on a prefix match
+        int next;                            // index of the next handler
+#ifdef OSC_PROFILE
+        OSCProfileStats *profile; // the statistics of the route
+#endif
+    };
+
+    // the prefix tree, nodes[0] is the root
+    Node *nodes;
+    int   nodeCount;
+    int   nodeCapacity;
+
+    // a full-match route without wildcards
+    struct Literal
+    {
+        uint32_t hash;    // hash of the whole address
+        int      name;    // offset of the address in names
+        int      length;  // length of the address
+        int      handler; // index of the first handler
+    };
+
+    // the literal routes in the order they were added
+    Literal *literals;
+    int      literalCount;
+    int      literalCapacity;
+
+    // open addressing index of the literals by hash, -1 marks a free entry
+    // its size is a power of two and it is kept at most half full
+    int *literalIndex;
+    int  literalIndexSize;
+
+    // the handlers of all the nodes and literals
+    Handler *handlers;
+    int      handlerCount;
+    int      handlerCapacity;
+
+    // the number of handlers in the tree
+    int treeHandlerCount;
+
+    // the null terminated names of all the nodes and literals
+    char *names;
+    int   namesSize;
+    int   namesCapacity;
+
+    // error codes for potential runtime problems
+    OSCErrorCode error;
+
+    // returns the node for the address, creating the missing ones
+    // returns -1 if the tree could not be grown
+    int findOrAddNode(const char *address);
+
+    // returns the child of parent with that component, creating it if needed
+    int findOrAddChild(int parent, const char *component, int length);
+
+    // copies a name into names, returns its offset or -1
+    int addName(const char *name, int length);
+
+    // returns the literal for the address, creating it if needed
+    // returns -1 if the table could not be grown
+    int findOrAddLiteral(const char *address);
+
+    // returns the literal with that address, -1 if there is none
+    int findLiteral(uint32_t hash, const char *address, int length);
+
+    // rebuilds the index with room for more literals
+    bool growLiteralIndex();
+
+    // appends a handler to the chain starting at first
+    // first is NULL if its node or literal could not be created
+    bool addHandler(int        *first,
+                    const char *address,
+                    void (*dispatch)(OSCMessage &),
+                    void (*route)(OSCMessage &, int));
+
+    // calls the handlers of the literals matching the message
+    int dispatchLiterals(OSCMessage &msg);
+
+    // dispatches the message below node, offset is the end of the
+    // address component that node matched
+    int walk(int node, OSCMessage &msg, const char *address, int offset);
+
+  public:
+    OSCRouter();
+    ~OSCRouter();
+
+    // calls the function with the message if its address fully matches
+    // returns false if the route could not be added
+    bool addRoute(const char *address, void (*callback)(OSCMessage &));
+
+    // calls the function with the message if the address matches the start
+    // of the message's address, along with the offset after the match
+    // returns false if the route could not be added
+    bool addRoute(const char *address, void (*callback)(OSCMessage &, int));
+
+    // removes all the routes
+    OSCRouter &empty();
+
+    // calls every handler that matches the message's address
+    // returns the number of handlers called
+    int dispatch(OSCMessage &msg);
+
+    bool         hasError() { return error != OSC_OK; }
+    OSCErrorCode getError() { return error; }
+};
@@ -0,0 +1,436 @@
+#pragma once
+
+#include <atomic>
+
+#include "daisy_core.h"
+#include "OSCMessage.h"
+#include "OSCBundle.h"
+#include "OSCTiming.h"
+
+// what happens to a message whose timetag has already passed when it arrives
+typedef enum
+{
+    OSC_LATE_DISPATCH = 0, // dispatch it right away
+    OSC_LATE_DROP,         // discard it
+} OSCLatePolicy;
+
+// a fixed-size binary heap of messages ordered by timetag
+// messages with the same timetag come out in the order they went in
+template <size_t Capacity>
+class OSCEventHeap
+{
+  public:
+    struct Event
+    {
+        uint64_t    time;  // 32.32 fixed point timetag
+        uint32_t    order; // breaks ties between equal timetags
+        OSCMessage *message;
+    };
+
+  private:
+    // the heap of pending events, earliest first
+    Event  events[Capacity];
+    size_t count;
+
+    // incremented for every pushed event
+    uint32_t sequence;
+
+    // whether event a is due before event b
+    static bool earlier(const Event &a, const Event &b)
+    {
+        int64_t diff = (int64_t)(a.time - b.time);
+        if(diff != 0)
+        {
+            return diff < 0;
+        }
+        return (int32_t)(a.order - b.order) < 0;
+    }
+
+  public:
+    OSCEventHeap() : count(0), sequence(0) {}
+
+    // adds an event, the heap must not be full
+    void push(uint64_t time, OSCMessage *message)
+    {
+        size_t i = count++;
+        Event  e = {time, sequence++, message};
+        // sift up
+        while(i > 0)
+        {
+            size_t parent = (i - 1) / 2;
+            if(!earlier(e, events[parent]))
+            {
+                break;
+            }
+            events[i] = events[parent];
+            i         = parent;
+        }
+        events[i] = e;
+    }
+
+    // removes the earliest event, the heap must not be empty
+    Event pop()
+    {
+        Event top = events[0];
+        Event e   = events[--count];
+        // sift down
+        size_t i = 0;
+        while(true)
+        {
+            size_t child = 2 * i + 1;
+            if(child >= count)
+            {
+                break;
+            }
+            if(child + 1 < count && earlier(events[child + 1], events[child]))
+            {
+                child++;
+            }
+            if(!earlier(events[child], e))
+            {
+                break;
+            }
+            events[i] = events[child];
+            i         = child;
+        }
+        if(count > 0)
+        {
+            events[i] = e;
+        }
+        return top;
+    }
+
+    // the earliest event, the heap must not be empty
+    const Event &top() { return events[0]; }
+
+    void   clear() { count = 0; }
+    size_t size() { return count; }
+    bool   full() { return count == Capacity; }
+};
+
+// holds future-stamped messages and releases them at their deadline
+//
+// scheduling and releasing happen in the same context, see
+// OSCBlockScheduler for releasing from the audio callback
+// the messages are not copied, they must stay alive until released
+template <size_t Capacity>
+class OSCScheduler
+{
+    // the pending events
+    OSCEventHeap<Capacity> heap;
+
+    // called for every message that is released
+    void (*callback)(OSCMessage &);
+
+    OSCLatePolicy latePolicy;
+
+    // counters
+    uint32_t lateCount;
+    uint32_t dropCount;
+
+  public:
+    OSCScheduler(void (*_callback)(OSCMessage &),
+                 OSCLatePolicy _latePolicy = OSC_LATE_DISPATCH)
+    : callback(_callback),
+      latePolicy(_latePolicy),
+      lateCount(0),
+      dropCount(0)
+    {
+    }
+
+    // schedules the message for the given time
+    // immediate timetags and late messages are handled right away
+    // returns false if the message was dropped
+    bool schedule(OSCMessage &msg, osctime_t time, osctime_t now)
+    {
+        // the fast path, nothing to queue
+        if(oscTimeIsImmediate(time))
+        {
+            callback(msg);
+            return true;
+        }
+        uint64_t deadline = oscTimeToFixed(time);
+        if((int64_t)(deadline - oscTimeToFixed(now)) <= 0)
+        {
+            lateCount++;
+            if(latePolicy == OSC_LATE_DROP)
+            {
+                dropCount++;
+                return false;
+            }
+            callback(msg);
+            return true;
+        }
+        if(heap.full())
+        {
+            dropCount++;
+            return false;
+        }
+        heap.push(deadline, &msg);
+        return true;
+    }
+
+    // schedules every message of the bundle and its nested bundles
+    // at the timetag of the bundle that contains it
+    // returns false if any of them was dropped
+    bool schedule(OSCBundle &bundle, osctime_t now)
+    {
+        bool scheduled = true;
+        for(int i = 0; i < bundle.size(); i++)
+        {
+            OSCMessage *msg = bundle.getOSCMessage(i);
+            if(msg != NULL)
+                scheduled &= schedule(*msg, bundle.getTimetag(), now);
+            else
+                scheduled &= schedule(*bundle.getBundle(i), now);
+        }
+        return scheduled;
+    }
+
+    // releases every event that is due at the given time
+    // returns the number of released events
+    int poll(osctime_t now)
+    {
+        uint64_t current  = oscTimeToFixed(now);
+        int      released = 0;
+        while(heap.size() > 0 && (int64_t)(heap.top().time - current) <= 0)
+        {
+            callback(*heap.pop().message);
+            released++;
+        }
+        return released;
+    }
+
+    // the timetag of the earliest pending event
+    // returns false if nothing is pending
+    bool nextDeadline(osctime_t *time)
+    {
+        if(heap.size() == 0)
+        {
+            return false;
+        }
+        *time = oscTimeFromFixed(heap.top().time);
+        return true;
+    }
+
+    // discards all pending events
+    void clear() { heap.clear(); }
+
+    // the number of pending events
+    size_t size() { return heap.size(); }
+
+    // the number of messages that arrived after their timetag
+    uint32_t late() { return lateCount; }
+
+    // the number of messages that were discarded, late or because it was full
+    uint32_t dropped() { return dropCount; }
+};
+
+// a message released inside an audio block
+typedef struct
+{
+    OSCMessage *message;
+    size_t      offset; // the sample within the block at which it is due
+} OSCBlockEvent;
+
+// releases scheduled messages from the audio callback with sample accuracy
+//
+// schedule() is called from the main loop, process() from the audio callback
+// the two only share single-producer/single-consumer rings, an inbox going
+// to the audio callback and a return ring coming back, so neither side
+// locks and the audio callback never allocates
+//
+// the messages are not copied, the scheduler owns a message from the call
+// to schedule() that takes it until reclaim() returns it to the main loop
+// - a released message is returned once the next block has been processed,
+//   the audio callback may use it until then
+// - a dropped message, late or because the heap was full, is returned in
+//   the same way without being released
+// the main loop must not change or free a message while the scheduler owns
+// it, nor a bundle while it owns any of its messages
+template <size_t Capacity>
+class OSCBlockScheduler
+{
+    struct Pending
+    {
+        uint64_t    time;
+        OSCMessage *message;
+    };
+
+    // messages handed over by schedule(), waiting to enter the heap
+    Pending               inbox[Capacity];
+    std::atomic<uint32_t> inboxHead;
+    std::atomic<uint32_t> inboxTail;
+
+    // the pending events, only touched by process()
+    OSCEventHeap<Capacity> heap;
+
+    // messages the audio callback is done with, waiting for reclaim()
+    // every message the scheduler owns has a place in it, so it can't overflow
+    OSCMessage           *returned[2 * Capacity];
+    std::atomic<uint32_t> returnedHead;
+    std::atomic<uint32_t> returnedTail;
+
+    // the end of what process() wrote to returned, published to the main
+    // loop at the start of the next block
+    uint32_t returnedWritten;
+
+    OSCLatePolicy latePolicy;
+
+    // counters
+    std::atomic<uint32_t> lateCount;
+    std::atomic<uint32_t> dropCount;
+
+    // hands a message back to the main loop, see process()
+    void giveBack(OSCMessage *message)
+    {
+        returned[returnedWritten++ % (2 * Capacity)] = message;
+    }
+
+    // moves everything from the inbox to the heap
+    void drainInbox(uint64_t start)
+    {
+        uint32_t first = inboxTail.load(std::memory_order_relaxed);
+        uint32_t last  = inboxHead.load(std::memory_order_acquire);
+        for(; first != last; first++)
+        {
+            Pending &p = inbox[first % Capacity];
+            // immediate messages are due at the start of the block
+            uint64_t time = p.time == oscTimeToFixed(oscTimeImmediate)
+                                ? start
+                                : p.time;
+            if((int64_t)(time - start) < 0)
+            {
+                lateCount.fetch_add(1, std::memory_order_relaxed);
+                if(latePolicy == OSC_LATE_DROP)
+                {
+                    dropCount.fetch_add(1, std::memory_order_relaxed);
+                    giveBack(p.message);
+                    continue;
+                }
+                time = start;
+            }
+            if(heap.full())
+            {
+                dropCount.fetch_add(1, std::memory_order_relaxed);
+                giveBack(p.message);
+                continue;
+            }
+            heap.push(time, p.message);
+        }
+        inboxTail.store(first, std::memory_order_release);
+    }
+
+  public:
+    OSCBlockScheduler(OSCLatePolicy _latePolicy = OSC_LATE_DISPATCH)
+    : inboxHead(0),
+      inboxTail(0),
+      returnedHead(0),
+      returnedTail(0),
+      returnedWritten(0),
+      latePolicy(_latePolicy),
+      lateCount(0),
+      dropCount(0)
+    {
+    }
+
+    // hands the message over to the audio callback for the given time
+    // returns false if the inbox is full, or the scheduler owns as many
+    // messages as it can return, the message is then dropped and stays with
+    // the caller
+    bool schedule(OSCMessage &msg, osctime_t time)
+    {
+        uint32_t last = inboxHead.load(std::memory_order_relaxed);
+        if(last - inboxTail.load(std::memory_order_acquire) == Capacity
+           || last - returnedTail.load(std::memory_order_relaxed)
+                  == 2 * Capacity)
+        {
+            dropCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        inbox[last % Capacity] = {oscTimeToFixed(time), &msg};
+        inboxHead.store(last + 1, std::memory_order_release);
+        return true;
+    }
+
+    // schedules every message of the bundle and its nested bundles
+    // at the timetag of the bundle that contains it
+    bool schedule(OSCBundle &bundle)
+    {
+        bool scheduled = true;
+        for(int i = 0; i < bundle.size(); i++)
+        {
+            OSCMessage *msg = bundle.getOSCMessage(i);
+            if(msg != NULL)
+                scheduled &= schedule(*msg, bundle.getTimetag());
+            else
+                scheduled &= schedule(*bundle.getBundle(i));
+        }
+        return scheduled;
+    }
+
+    // returns a message the scheduler no longer owns, released in an
+    // earlier block or dropped, or NULL if there is none
+    // called from the main loop
+    OSCMessage *reclaim()
+    {
+        uint32_t first = returnedTail.load(std::memory_order_relaxed);
+        if(first == returnedHead.load(std::memory_order_acquire))
+        {
+            return NULL;
+        }
+        OSCMessage *message = returned[first % (2 * Capacity)];
+        returnedTail.store(first + 1, std::memory_order_release);
+        return message;
+    }
+
+    // called once per audio block with the time of its first sample
+    // writes the messages due within the block to events, in order,
+    // with the sample offset at which each one is due
+    // the events are valid until the next call, the messages are then
+    // returned through reclaim()
+    // messages that don't fit in events stay queued for the next block
+    // returns the number of events written
+    size_t process(osctime_t      blockStart,
+                   float          sampleRate,
+                   size_t         blockSize,
+                   OSCBlockEvent *events,
+                   size_t         maxEvents)
+    {
+        // the previous block is over, what it released goes back
+        returnedHead.store(returnedWritten, std::memory_order_release);
+
+        uint64_t start = oscTimeToFixed(blockStart);
+        drainInbox(start);
+
+        // the sample rate as 16.16 and the block's duration as 32.32 fixed point
+        // blocks must be shorter than 65536 samples
+        uint64_t rate     = (uint64_t)(sampleRate * 65536.0f);
+        uint64_t duration = ((uint64_t)blockSize << 48) / rate;
+        size_t   count    = 0;
+        while(count < maxEvents && heap.size() > 0)
+        {
+            int64_t delta = (int64_t)(heap.top().time - start);
+            if(delta >= (int64_t)duration)
+            {
+                break;
+            }
+            OSCMessage *message = heap.pop().message;
+            giveBack(message);
+            // events left over from a previous block are due right away
+            // delta is below one block so the product can't overflow
+            size_t offset
+                = delta > 0 ? (size_t)(((uint64_t)delta * rate) >> 48) : 0;
+            events[count].message = message;
+            events[count].offset = offset < blockSize ? offset : blockSize - 1;
+            count++;
+        }
+        return count;
+    }
+
+    // the number of messages that arrived after their timetag
+    uint32_t late() { return lateCount.load(std::memory_order_relaxed); }
+
+    // the number of messages that were discarded
+    uint32_t dropped() { return dropCount.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <string.h>
+#include <type_traits>
+
+#include "daisy_core.h"
+#include "OSCData.h"
+#include "OSCTiming.h"
+
+// fixed-shape messages with their layout worked out at compile time
+//
+// a schema names an address and the types of its arguments, for example
+//   OSC_SCHEMA_ADDRESS(VoiceFreq, "/synth/voice/freq");
+//   typedef OSCSchema<VoiceFreq, int32_t, float> VoiceFreqMsg;
+// the encoded size, the type tags and the offset of every argument are
+// constants, so encoding copies a prebuilt header and writes each argument
+// in place, and decoding compares the header once then reads each argument
+// from its offset, without going through OSCData
+// only arguments of a fixed size can be part of a schema
+// the layout is computed with C++14 constexpr functions
+
+// declares a type holding an address for OSCSchema
+#define OSC_SCHEMA_ADDRESS(name, addr)                          \
+    struct name                                                 \
+    {                                                           \
+        static constexpr const char *value() { return addr; } \
+    }
+
+/*=============================================================================
+    ARGUMENT TYPES
+ =============================================================================*/
+
+// the type tag and size of each argument type
+template <typename T, typename = void>
+struct OSCSchemaType
+{
+    static_assert(sizeof(T) == 0,
+                  "OSCSchema arguments must be 32 or 64-bit integers, float, "
+                  "double or osctime_t");
+};
+
+template <typename T>
+struct OSCSchemaType<T,
+                     typename std::enable_if<std::is_integral<T>::value
+                                             && sizeof(T) == 4>::type>
+{
+    static constexpr char tag  = 'i';
+    static constexpr int  size = 4;
+    static void write(uint8_t *p, T value)
+    {
+        uint32_t u = BigEndian((uint32_t)value);
+        memcpy(p, &u, 4);
+    }
+    static T read(const uint8_t *p)
+    {
+        uint32_t u;
+        memcpy(&u, p, 4);
+        return (T)BigEndian(u);
+    }
+};
+
+template <typename T>
+struct OSCSchemaType<T,
+                     typename std::enable_if<std::is_integral<T>::value
+                                             && sizeof(T) == 8>::type>
+{
+    static constexpr char tag  = 'h';
+    static constexpr int  size = 8;
+    static void write(uint8_t *p, T value)
+    {
+        uint64_t u = BigEndian((uint64_t)value);
+        memcpy(p, &u, 8);
+    }
+    static T read(const uint8_t *p)
+    {
+        uint64_t u;
+        memcpy(&u, p, 8);
+        return (T)BigEndian(u);
+    }
+};
+
+template <>
+struct OSCSchemaType<float>
+{
+    static constexpr char tag  = 'f';
+    static constexpr int  size = 4;
+    static void           write(uint8_t *p, float value)
+    {
+        uint32_t u;
+        memcpy(&u, &value, 4);
+        OSCSchemaType<uint32_t>::write(p, u);
+    }
+    static float read(const uint8_t *p)
+    {
+        uint32_t u = OSCSchemaType<uint32_t>::read(p);
+        float    f;
+        memcpy(&f, &u, 4);
+        return f;
+    }
+};
+
+template <>
+struct OSCSchemaType<double>
+{
+    static constexpr char tag  = 'd';
+    static constexpr int  size = 8;
+    static void           write(uint8_t *p, double value)
+    {
+        uint64_t u;
+        memcpy(&u, &value, 8);
+        OSCSchemaType<uint64_t>::write(p, u);
+    }
+    static double read(const uint8_t *p)
+    {
+        uint64_t u = OSCSchemaType<uint64_t>::read(p);
+        double   d;
+        memcpy(&d, &u, 8);
+        return d;
+    }
+};
+
+template <>
+struct OSCSchemaType<osctime_t>
+{
+    static constexpr char tag  = 't';
+    static constexpr int  size = 8;
+    static void           write(uint8_t *p, osctime_t value)
+    {
+        OSCSchemaType<uint32_t>::write(p, value.seconds);
+        OSCSchemaType<uint32_t>::write(p + 4, value.fractionofseconds);
+    }
+    static osctime_t read(const uint8_t *p)
+    {
+        osctime_t t;
+        t.seconds           = OSCSchemaType<uint32_t>::read(p);
+        t.fractionofseconds = OSCSchemaType<uint32_t>::read(p + 4);
+        return t;
+    }
+};
+
+/*=============================================================================
+    SCHEMA
+ =============================================================================*/
+
+// the length of a string, at compile time
+constexpr int oscSchemaLength(const char *s)
+{
+    return *s == '\0' ? 0 : 1 + oscSchemaLength(s + 1);
+}
+
+// the size of a string once terminated and padded to 4 bytes
+constexpr int oscSchemaPadded(int length)
+{
+    return (length + 4) & ~3;
+}
+
+// the total size of the first n of the arguments
+template <typename... Args>
+constexpr int oscSchemaArgsSize(int n)
+{
+    const int sizes[] = {0, OSCSchemaType<Args>::size...};
+    int       total   = 0;
+    for(int i = 1; i <= n; i++)
+    {
+        total += sizes[i];
+    }
+    return total;
+}
+
+template <typename Address, typename... Args>
+class OSCSchema
+{
+  public:
+    // the number of arguments
+    static constexpr int count = sizeof...(Args);
+
+    // the size of the address and the type tags, where the arguments start
+    static constexpr int headerSize
+        = oscSchemaPadded(oscSchemaLength(Address::value()))
+          + oscSchemaPadded(1 + count);
+
+    // the encoded size of the message
+    static constexpr int size = headerSize + oscSchemaArgsSize<Args...>(count);
+
+    // the offset of the argument at that position
+    static constexpr int offset(int position)
+    {
+        return headerSize + oscSchemaArgsSize<Args...>(position);
+    }
+
+  private:
+    // the address and type tags as they appear on the wire
+    struct Header
+    {
+        uint8_t bytes[headerSize];
+
+        constexpr Header() : bytes{}
+        {
+            const char *address = Address::value();
+            int         i       = 0;
+            for(; address[i] != '\0'; i++)
+            {
+                bytes[i] = address[i];
+            }
+            const char tags[] = {',', OSCSchemaType<Args>::tag..., '\0'};
+            int        t      = oscSchemaPadded(i);
+            for(i = 0; tags[i] != '\0'; i++)
+            {
+                bytes[t + i] = tags[i];
+            }
+        }
+    };
+
+    static constexpr Header header = Header();
+
+    template <int Position>
+    static void writeArgs(uint8_t *)
+    {
+    }
+
+    template <int Position, typename T, typename... Rest>
+    static void writeArgs(uint8_t *buffer, const T &value, const Rest &...rest)
+    {
+        OSCSchemaType<T>::write(buffer + offset(Position), value);
+        writeArgs<Position + 1>(buffer, rest...);
+    }
+
+    template <int Position>
+    static void readArgs(const uint8_t *)
+    {
+    }
+
+    template <int Position, typename T, typename... Rest>
+    static void readArgs(const uint8_t *packet, T &value, Rest &...rest)
+    {
+        value = OSCSchemaType<T>::read(packet + offset(Position));
+        readArgs<Position + 1>(packet, rest...);
+    }
+
+  public:
+    // writes the message to the buffer
+    // returns the number of bytes the message needs
+    // nothing is written if that is more than bufferSize
+    static int encode(uint8_t *buffer, size_t bufferSize, Args... args)
+    {
+        if((size_t)size <= bufferSize)
+        {
+            memcpy(buffer, header.bytes, headerSize);
+            writeArgs<0>(buffer, args...);
+        }
+        return size;
+    }
+
+    // whether the packet is a message of this schema
+    static bool matches(const uint8_t *packet, int length)
+    {
+        return length == size && memcmp(packet, header.bytes, headerSize) == 0;
+    }
+
+    // reads the arguments of a message of this schema
+    // returns false, leaving the arguments untouched, if it is another message
+    static bool decode(const uint8_t *packet, int length, Args &...args)
+    {
+        if(!matches(packet, length))
+        {
+            return false;
+        }
+        readArgs<0>(packet, args...);
+        return true;
+    }
+
+    // sends the message with a single transmit call
+    template <typename T>
+    static void send(T &p, Args... args)
+    {
+        uint8_t buffer[size];
+        encode(buffer, size, args...);
+        p.BlockingTransmit(buffer, size);
+    }
+};
+
+template <typename Address, typename... Args>
+constexpr typename OSCSchema<Address, Args...>::Header
+    OSCSchema<Address, Args...>::header;
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <string.h>
+#include <type_traits>
+#include <utility>
+
+#include "daisy_core.h"
+
+// messages up to this size are sent with a single transmit call
+// from a buffer on the stack
+#ifndef OSC_SEND_BUFFER_SIZE
+#define OSC_SEND_BUFFER_SIZE 256
+#endif
+
+// the number of segments handed to a transport at once
+#ifndef OSC_SEND_SEGMENTS
+#define OSC_SEND_SEGMENTS 16
+#endif
+
+// scatter-gather sending
+//
+// send() works with two kinds of transports
+// - ones with BlockingTransmit(uint8_t *bytes, size_t count), such as
+//   daisy::UartHandler, which are handed the packet in runs of up to
+//   OSC_SEND_BUFFER_SIZE bytes, copied together on the stack
+// - ones with TransmitSegments(const OSCSegment *segments, int count),
+//   such as a DMA linked list or writev(), which are handed a list of
+//   pieces of the packet, strings and blobs by reference where they are
+//   stored, everything else copied together on the stack
+//   the segments are only valid during the call, a long packet takes
+//   several calls of up to OSC_SEND_SEGMENTS segments
+// a transport with both is handed segments
+
+// one piece of a packet
+typedef struct
+{
+    const uint8_t *data;
+    size_t         length;
+} OSCSegment;
+
+// whether the transport takes segments
+template <typename T>
+class OSCHasSegments
+{
+    template <typename U>
+    static auto test(int) -> decltype(std::declval<U &>().TransmitSegments(
+                                          (const OSCSegment *)NULL, 0),
+                                      std::true_type());
+    template <typename>
+    static std::false_type test(...);
+
+  public:
+    static const bool value = decltype(test<T>(0))::value;
+};
+
+// writes a packet to a transport piece by piece, see above
+// copy() takes small pieces which don't outlive the call, reference()
+// pieces which stay put until flush()
+template <typename T, bool = OSCHasSegments<T>::value>
+class OSCSegmentWriter;
+
+// gathers segments for TransmitSegments()
+template <typename T>
+class OSCSegmentWriter<T, true>
+{
+    T         &transport;
+    OSCSegment segments[OSC_SEND_SEGMENTS];
+    int        count;
+    // where copied pieces are kept until they are transmitted
+    uint8_t scratch[OSC_SEND_BUFFER_SIZE];
+    size_t  used;
+
+    OSCSegment &next()
+    {
+        if(count == OSC_SEND_SEGMENTS)
+        {
+            flush();
+        }
+        return segments[count++];
+    }
+
+    // makes room for length more bytes in scratch and one more segment
+    void reserve(size_t length)
+    {
+        if(used + length > sizeof(scratch) || count == OSC_SEND_SEGMENTS)
+        {
+            flush();
+        }
+    }
+
+    // adds the bytes just written to scratch
+    void append(size_t length)
+    {
+        uint8_t *start = scratch + used;
+        used += length;
+        // consecutive copies make one segment
+        if(count > 0
+           && segments[count - 1].data + segments[count - 1].length == start)
+        {
+            segments[count - 1].length += length;
+            return;
+        }
+        OSCSegment &s = next();
+        s.data        = start;
+        s.length      = length;
+    }
+
+  public:
+    OSCSegmentWriter(T &_transport) : transport(_transport), count(0), used(0)
+    {
+    }
+
+    // writes a small packet in one pass, see encode() of the packet
+    // returns false without writing anything if it doesn't fit
+    template <typename P>
+    bool encode(P &packet)
+    {
+        reserve(0);
+        size_t space = sizeof(scratch) - used;
+        size_t size  = packet.encode(scratch + used, space);
+        if(size > space)
+        {
+            return false;
+        }
+        append(size);
+        return true;
+    }
+
+    void copy(const void *bytes, size_t length)
+    {
+        if(length == 0)
+        {
+            return;
+        }
+        reserve(length);
+        memcpy(scratch + used, bytes, length);
+        append(length);
+    }
+
+    void reference(const uint8_t *bytes, size_t length)
+    {
+        if(length == 0)
+        {
+            return;
+        }
+        OSCSegment &s = next();
+        s.data        = bytes;
+        s.length      = length;
+    }
+
+    void zeros(size_t length)
+    {
+        static const uint8_t zero[64] = {0};
+        // padding is copied, anything longer points at the zeros
+        if(length <= 4)
+        {
+            copy(zero, length);
+            return;
+        }
+        while(length > 0)
+        {
+            size_t run = length < sizeof(zero) ? length : sizeof(zero);
+            reference(zero, run);
+            length -= run;
+        }
+    }
+
+    void flush()
+    {
+        if(count > 0)
+        {
+            transport.TransmitSegments(segments, count);
+        }
+        count = 0;
+        used  = 0;
+    }
+};
+
+// copies everything together for BlockingTransmit()
+template <typename T>
+class OSCSegmentWriter<T, false>
+{
+    T      &transport;
+    uint8_t buffer[OSC_SEND_BUFFER_SIZE];
+    size_t  used;
+
+  public:
+    OSCSegmentWriter(T &_transport) : transport(_transport), used(0) {}
+
+    // writes a small packet in one pass, see encode() of the packet
+    // returns false without writing anything if it doesn't fit
+    template <typename P>
+    bool encode(P &packet)
+    {
+        size_t space = sizeof(buffer) - used;
+        size_t size  = packet.encode(buffer + used, space);
+        if(size > space)
+        {
+            return false;
+        }
+        used += size;
+        return true;
+    }
+
+    void copy(const void *bytes, size_t length)
+    {
+        const uint8_t *from = (const uint8_t *)bytes;
+        while(length > 0)
+        {
+            if(used == sizeof(buffer))
+            {
+                flush();
+            }
+            size_t space = sizeof(buffer) - used;
+            size_t run   = length < space ? length : space;
+            memcpy(buffer + used, from, run);
+            used += run;
+            from += run;
+            length -= run;
+        }
+    }
+
+    void reference(const uint8_t *bytes, size_t length) { copy(bytes, length); }
+
+    void zeros(size_t length)
+    {
+        while(length > 0)
+        {
+            if(used == sizeof(buffer))
+            {
+                flush();
+            }
+            size_t space = sizeof(buffer) - used;
+            size_t run   = length < space ? length : space;
+            memset(buffer + used, 0, run);
+            used += run;
+            length -= run;
+        }
+    }
+
+    void flush()
+    {
+        if(used > 0)
+        {
+            transport.BlockingTransmit(buffer, used);
+        }
+        used = 0;
+    }
+};
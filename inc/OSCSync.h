@@ -0,0 +1,125 @@
+#pragma once
+
+#include "daisy_core.h"
+#include "OSCMessage.h"
+
+// synchronization of oscTime() with the clock of another machine, the host
+//
+// the exchange is the one of NTP, over OSC messages
+//   the Daisy sends /_osc/sync with t0, its monotonic time when sending
+//   the host answers /_osc/sync/reply with t0, t1 and t2, its own times when
+//   the request arrived and when the reply left
+//   the Daisy notes t3, the monotonic time when the reply arrived
+// which measures the offset between the two clocks, assuming the delay is
+// the same both ways, and the round trip delay
+//
+// OSCSync keeps the last OSC_SYNC_SAMPLES measurements and fits a line
+// through the ones with a short round trip, since queueing only makes the
+// measurements worse, the line gives the offset and its drift, which are
+// applied to oscTime() with oscTimeSetCorrection() after every reply
+// the correction may step the time, backwards too
+//
+//   OSCSync sync;
+//   every second or so:
+//       sync.request(msg);
+//       msg.send(uart);
+//   on receiving a message:
+//       if(sync.receive(msg)) ...
+//
+// the host answers with oscSyncRespond()
+
+#define OSC_SYNC_ADDRESS "/_osc/sync"
+#define OSC_SYNC_REPLY_ADDRESS "/_osc/sync/reply"
+
+// the number of measurements kept
+// the drift is only as good as the time they span, at one request a
+// second 16 measurements keep it within a few 10^-6 on a USB link
+#ifndef OSC_SYNC_SAMPLES
+#define OSC_SYNC_SAMPLES 16
+#endif
+
+// the largest drift believed, in seconds per second, crystals are within
+// a few 10^-5
+#define OSC_SYNC_MAX_DRIFT 0.001
+
+class OSCSync
+{
+    // one exchange
+    struct Sample
+    {
+        uint64_t time;   // the middle of the exchange, monotonic
+        uint64_t offset; // host time - monotonic time, 32.32 fixed point
+        uint64_t delay;  // the round trip, less the host's time
+    };
+
+    Sample samples[OSC_SYNC_SAMPLES];
+    int    count; // the measurements in samples
+    int    next;  // where the next one goes
+
+    bool     apply;
+    uint64_t estimateTime;   // the monotonic time of the estimated offset
+    uint64_t estimateOffset; // 32.32 fixed point
+    double   drift;          // seconds per second
+    double   error;      // rms distance of the used measurements to the line
+    double   confidence; // 0 to 1
+    int      used;       // the measurements on the line
+
+    uint64_t shortestDelay();
+    void     estimate();
+
+  public:
+    // apply: whether to correct oscTime(), otherwise the estimate is only
+    // kept for monitoring
+    OSCSync(bool apply = true);
+
+    // forgets every measurement, the correction of oscTime() stays
+    void reset();
+
+    // fills the message with a request stamped with the current time
+    OSCMessage &request(OSCMessage &msg);
+
+    // the same with the monotonic time the request leaves
+    OSCMessage &request(OSCMessage &msg, uint64_t now);
+
+    // takes a reply, returns false, leaving the estimate alone, for any
+    // other message
+    bool receive(OSCMessage &msg);
+
+    // the same with the monotonic time the reply arrived
+    bool receive(OSCMessage &msg, uint64_t arrival);
+
+    // the estimated offset between the host's clock and the monotonic time
+    // now, as 32.32 fixed point, 0 without measurements
+    uint64_t getOffset();
+
+    // the same at the monotonic time at
+    uint64_t getOffset(uint64_t at);
+
+    // the estimated drift of the host's clock against the local one, in
+    // seconds per second
+    double getDrift() { return drift; }
+
+    // the shortest round trip of the kept measurements, in seconds
+    double getDelay();
+
+    // the rms distance of the used measurements to the fitted line, in
+    // seconds
+    double getError() { return error; }
+
+    // how much the estimate can be trusted, from 0 to 1
+    // the share of the kept measurements that were used, lowered when they
+    // scatter by more than half the shortest round trip
+    double getConfidence() { return confidence; }
+
+    // the number of measurements kept
+    int getSamples() { return count; }
+};
+
+// answers a sync request, the host side of the exchange
+// received and sent are the host's times when the request arrived and
+// when the reply leaves, the reply should be sent right after stamping it
+// returns false, leaving reply alone, for any other message
+bool oscSyncRespond(OSCMessage &request,
+                    OSCMessage &reply,
+                    osctime_t   received,
+                    osctime_t   sent);
@@ -8,8 +8,79 @@ typedef struct
     uint32_t fractionofseconds;
 } osctime_t;
 
+// the timetag which means "now" in bundles
+static const osctime_t oscTimeImmediate = {0, 1};
+
+// timetags as 32.32 fixed point numbers, for arithmetic and comparisons
+static inline uint64_t oscTimeToFixed(osctime_t t)
+{
+    return ((uint64_t)t.seconds << 32) | t.fractionofseconds;
+}
+
+static inline osctime_t oscTimeFromFixed(uint64_t fixed)
+{
+    osctime_t t;
+    t.seconds           = (uint32_t)(fixed >> 32);
+    t.fractionofseconds = (uint32_t)fixed;
+    return t;
+}
+
+static inline bool oscTimeIsImmediate(osctime_t t)
+{
+    return t.seconds == 0 && t.fractionofseconds == 1;
+}
+
+// seconds between the NTP epoch (1900) and the Unix epoch (1970)
+#define OSC_NTP_UNIX_OFFSET 2208988800u
+
+// a Unix time as an NTP timetag
+static inline osctime_t oscTimeFromUnix(uint32_t seconds, uint32_t micros)
+{
+    osctime_t t;
+    t.seconds           = seconds + OSC_NTP_UNIX_OFFSET;
+    t.fractionofseconds = (uint32_t)(((uint64_t)micros << 32) / 1000000);
+    return t;
+}
+
+// the clock
+//
+// the time is read from a free-running counter, TIM2 on the target and the
+// monotonic clock on the host (OSC_HOST), converted to 32.32 fixed point
+// with a single multiply and shift, the scale being computed once
+// the 32-bit counter of the target wraps every 2^32 / f seconds, the clock
+// has to be read at least once per wrap to notice it
+//
+// the clock counts from the first read, adding the epoch offset gives NTP
+// timetags once the application knows the time of day, see oscTimeSetEpoch()
+// the offset can change at a constant rate, the drift, for following
+// another clock, see OSCSync
+
+// computes the scale from the timer's frequency, called by the first read
+// call it again after changing the clock tree or the timer's prescaler
+void oscTimeInit();
+
+// the time since the first read, as 32.32 fixed point
+uint64_t oscTimeMonotonic();
+
+// the time since the first read plus the epoch offset
 osctime_t oscTime();
+
+// sets the epoch offset so that oscTime() returns now at this moment,
+// without drift
+void oscTimeSetEpoch(osctime_t now);
+
+// the epoch offset, as 32.32 fixed point, setting it stops the drift
+void     oscTimeSetOffset(uint64_t offset);
+uint64_t oscTimeGetOffset();
+
+// sets the epoch offset to offset at the monotonic time reference, from
+// where it changes by drift / 2^32 seconds per second
+// the drift is folded into the rate oscTime() counts at, to within about
+// one part in 2^31
+void    oscTimeSetCorrection(uint64_t reference, uint64_t offset, int32_t drift);
+int32_t oscTimeGetDrift();
+
 // int adcRead(int pin, osctime_t *t);
 // int capacitanceRead(int pin, osctime_t *t);
 
-// int inputRead(int pin, uint64_t *t);
\ No newline at end of file
+// int inputRead(int pin, uint64_t *t);
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <atomic>
+
+#include "daisy_core.h"
+#include "OSCMessage.h"
+
+// non-blocking transmission of OSCMessages over a DMA capable transport
+//
+// messages are encoded into a ring arena supplied by the caller and handed
+// to the transport's DmaTransmit one at a time, the completion callback
+// starts the next queued message
+// the arena has to be reachable by the DMA, on the Daisy Seed that means
+// placing it with DMA_BUFFER_MEM_SECTION
+//
+// the transport needs the same DmaTransmit signature as daisy::UartHandler
+// send() is called from one context only (the main loop)
+template <typename T, size_t MaxQueued = 8>
+class OSCTransmitQueue
+{
+    // a message encoded in the arena
+    struct Entry
+    {
+        size_t offset;
+        size_t length;
+    };
+
+    T       &transport;
+    uint8_t *arena;
+    size_t   arenaSize;
+
+    // the encoded messages, sent in order from tail to head
+    Entry                 entries[MaxQueued];
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+
+    // where the newest entry ends in the arena, only used by send()
+    size_t writeEnd;
+
+    // whether a transfer is in flight
+    std::atomic<bool> busy;
+
+    // the number of messages that did not fit
+    std::atomic<uint32_t> dropCount;
+
+    // finds room for a message of that size in the arena
+    // returns false if there is none
+    bool reserve(size_t length, size_t *offset)
+    {
+        uint32_t first = tail.load(std::memory_order_acquire);
+        uint32_t last  = head.load(std::memory_order_relaxed);
+        if(last - first == MaxQueued)
+        {
+            return false;
+        }
+        if(last == first)
+        {
+            // nothing is queued, start over at the beginning
+            *offset = 0;
+            return length <= arenaSize;
+        }
+        size_t start = entries[first % MaxQueued].offset;
+        if(writeEnd > start)
+        {
+            // the used region doesn't wrap, try the end then the beginning
+            if(arenaSize - writeEnd >= length)
+            {
+                *offset = writeEnd;
+                return true;
+            }
+            *offset = 0;
+            return length <= start;
+        }
+        // the used region wraps, only the gap in the middle is free
+        *offset = writeEnd;
+        return start - writeEnd >= length;
+    }
+
+    // starts the transfer of the oldest entry
+    // only called by whoever set busy
+    void transmitNext()
+    {
+        while(true)
+        {
+            uint32_t first = tail.load(std::memory_order_relaxed);
+            if(first == head.load(std::memory_order_acquire))
+            {
+                busy.store(false, std::memory_order_release);
+                // a message may have been queued while busy was still set
+                if(first == head.load(std::memory_order_acquire)
+                   || busy.exchange(true, std::memory_order_acquire))
+                {
+                    return;
+                }
+                continue;
+            }
+            Entry &e = entries[first % MaxQueued];
+            if(transport.DmaTransmit(
+                   arena + e.offset, e.length, NULL, transmitEnd, this)
+               == T::Result::OK)
+            {
+                return;
+            }
+            // the transport refused the transfer, drop the message
+            dropCount.fetch_add(1, std::memory_order_relaxed);
+            tail.store(first + 1, std::memory_order_release);
+        }
+    }
+
+    // completion callback of the transport, usually in interrupt context
+    static void transmitEnd(void *context, typename T::Result result)
+    {
+        OSCTransmitQueue *queue = (OSCTransmitQueue *)context;
+        if(result != T::Result::OK)
+        {
+            queue->dropCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        // release the entry which was just sent
+        queue->tail.fetch_add(1, std::memory_order_release);
+        queue->transmitNext();
+    }
+
+  public:
+    OSCTransmitQueue(T &_transport, uint8_t *_arena, size_t _arenaSize)
+    : transport(_transport),
+      arena(_arena),
+      arenaSize(_arenaSize),
+      head(0),
+      tail(0),
+      writeEnd(0),
+      busy(false),
+      dropCount(0)
+    {
+    }
+
+    // encodes the message into the arena and queues it for transmission
+    // returns false if the message had errors or didn't fit and was dropped
+    bool send(OSCMessage &msg)
+    {
+        if(msg.hasError())
+        {
+            return false;
+        }
+        size_t length = msg.bytes();
+        size_t offset;
+        if(!reserve(length, &offset))
+        {
+            dropCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        msg.encode(arena + offset, length);
+        uint32_t last            = head.load(std::memory_order_relaxed);
+        entries[last % MaxQueued] = {offset, length};
+        writeEnd                  = offset + length;
+        head.store(last + 1, std::memory_order_release);
+
+        // start the transport if it is idle
+        if(!busy.exchange(true, std::memory_order_acquire))
+        {
+            transmitNext();
+        }
+        return true;
+    }
+
+    // the number of messages waiting or in flight
+    size_t depth()
+    {
+        return head.load(std::memory_order_acquire)
+               - tail.load(std::memory_order_acquire);
+    }
+
+    // the number of messages that were dropped
+    uint32_t dropped() { return dropCount.load(std::memory_order_relaxed); }
+
+    // whether a transfer is in flight
+    bool isBusy() { return busy.load(std::memory_order_acquire); }
+};
@@ -0,0 +1,421 @@
+#include "OSCBundle.h"
+
+// the identifier which starts every bundle, including its terminator
+static const char bundleTag[8] = "#bundle";
+
+/*=============================================================================
+  CONSTRUCTORS / DESTRUCTOR
+=============================================================================*/
+
+OSCBundle::OSCBundle(osctime_t _timetag)
+{
+    timetag         = _timetag;
+    elements        = NULL;
+    elementCount    = 0;
+    elementCapacity = 0;
+    error           = OSC_OK;
+}
+
+OSCBundle::~OSCBundle()
+{
+    empty();
+}
+
+OSCBundle &OSCBundle::empty()
+{
+    error = OSC_OK;
+    for(int i = 0; i < elementCount; i++)
+    {
+        delete elements[i].message;
+        delete elements[i].bundle;
+    }
+    oscFree(elements);
+    elements        = NULL;
+    elementCount    = 0;
+    elementCapacity = 0;
+    return *this;
+}
+
+/*=============================================================================
+  SETTING DATA
+=============================================================================*/
+
+OSCBundle::Element *OSCBundle::reserveElement()
+{
+    if(elementCount == elementCapacity)
+    {
+        int      newCapacity = elementCapacity > 0 ? elementCapacity * 2 : 4;
+        Element *mem
+            = (Element *)oscRealloc(elements, sizeof(Element) * newCapacity);
+        if(mem == NULL)
+        {
+            error = ALLOCFAILED;
+            return NULL;
+        }
+        elements        = mem;
+        elementCapacity = newCapacity;
+    }
+    Element *e = &elements[elementCount];
+    e->message = NULL;
+    e->bundle  = NULL;
+    return e;
+}
+
+OSCMessage *OSCBundle::add(const char *address)
+{
+    Element *e = reserveElement();
+    if(e == NULL)
+    {
+        return NULL;
+    }
+    OSCMessage *msg = new OSCMessage(address);
+#ifdef OSC_NO_HEAP
+    // the pools return NULL once they run out
+    if(msg == NULL)
+    {
+        error = ALLOCFAILED;
+        return NULL;
+    }
+#endif
+    e->message = msg;
+    elementCount++;
+    return msg;
+}
+
+OSCMessage *OSCBundle::add(OSCMessage &_msg)
+{
+    Element *e = reserveElement();
+    if(e == NULL)
+    {
+        return NULL;
+    }
+    OSCMessage *msg = new OSCMessage(&_msg);
+#ifdef OSC_NO_HEAP
+    // the pools return NULL once they run out
+    if(msg == NULL)
+    {
+        error = ALLOCFAILED;
+        return NULL;
+    }
+#endif
+    e->message = msg;
+    elementCount++;
+    return msg;
+}
+
+OSCBundle *OSCBundle::addBundle(osctime_t _timetag)
+{
+    Element *e = reserveElement();
+    if(e == NULL)
+    {
+        return NULL;
+    }
+    OSCBundle *bundle = new OSCBundle(_timetag);
+#ifdef OSC_NO_HEAP
+    // the pools return NULL once they run out
+    if(bundle == NULL)
+    {
+        error = ALLOCFAILED;
+        return NULL;
+    }
+#endif
+    e->bundle = bundle;
+    elementCount++;
+    return bundle;
+}
+
+OSCBundle &OSCBundle::setTimetag(osctime_t _timetag)
+{
+    timetag = _timetag;
+    return *this;
+}
+
+/*=============================================================================
+  GETTING DATA
+=============================================================================*/
+
+OSCMessage *OSCBundle::getOSCMessage(int position)
+{
+    if(position >= 0 && position < elementCount)
+    {
+        return elements[position].message;
+    }
+    else
+    {
+        error = INDEX_OUT_OF_BOUNDS;
+        return NULL;
+    }
+}
+
+OSCMessage *OSCBundle::getOSCMessage(const char *address)
+{
+    for(int i = 0; i < elementCount; i++)
+    {
+        OSCMessage *msg = elements[i].message;
+        if(msg != NULL && msg->fullMatch(address))
+        {
+            return msg;
+        }
+    }
+    return NULL;
+}
+
+OSCBundle *OSCBundle::getBundle(int position)
+{
+    if(position >= 0 && position < elementCount)
+    {
+        return elements[position].bundle;
+    }
+    else
+    {
+        error = INDEX_OUT_OF_BOUNDS;
+        return NULL;
+    }
+}
+
+/*=============================================================================
+  PATTERN MATCHING
+=============================================================================*/
+
+bool OSCBundle::dispatch(const char *pattern,
+                         void (*callback)(OSCMessage &),
+                         int addr_offset)
+{
+    bool called = false;
+    for(int i = 0; i < elementCount; i++)
+    {
+        if(elements[i].message)
+            called |= elements[i].message->dispatch(
+                pattern, callback, addr_offset);
+        else
+            called
+                |= elements[i].bundle->dispatch(pattern, callback, addr_offset);
+    }
+    return called;
+}
+
+bool OSCBundle::route(const char *pattern,
+                      void (*callback)(OSCMessage &, int),
+                      int initial_offset)
+{
+    bool called = false;
+    for(int i = 0; i < elementCount; i++)
+    {
+        if(elements[i].message)
+            called |= elements[i].message->route(
+                pattern, callback, initial_offset);
+        else
+            called |= elements[i].bundle->route(
+                pattern, callback, initial_offset);
+    }
+    return called;
+}
+
+/*=============================================================================
+  SIZE
+=============================================================================*/
+
+int OSCBundle::bytes()
+{
+    // the "#bundle" tag and the timetag
+    int bundleSize = 16;
+    // then each element with its size
+    for(int i = 0; i < elementCount; i++)
+    {
+        bundleSize += 4;
+        if(elements[i].message)
+            bundleSize += elements[i].message->bytes();
+        else
+            bundleSize += elements[i].bundle->bytes();
+    }
+    return bundleSize;
+}
+
+/*=============================================================================
+  ENCODING
+=============================================================================*/
+
+int OSCBundle::encode(uint8_t *buffer, size_t bufferSize)
+{
+    if(hasError())
+    {
+        return 0;
+    }
+    // the sizes are added up once, then the elements are written
+    // and their size fields filled in behind them
+    int bundleSize = bytes();
+    if(buffer == NULL || (size_t)bundleSize > bufferSize)
+    {
+        return bundleSize;
+    }
+    encodeTo(buffer);
+    return bundleSize;
+}
+
+uint8_t *OSCBundle::encodeTo(uint8_t *ptr)
+{
+    memcpy(ptr, bundleTag, 8);
+    uint32_t word = BigEndian(timetag.seconds);
+    memcpy(ptr + 8, &word, 4);
+    word = BigEndian(timetag.fractionofseconds);
+    memcpy(ptr + 12, &word, 4);
+    ptr += 16;
+    for(int i = 0; i < elementCount; i++)
+    {
+        uint8_t *sizeField = ptr;
+        uint8_t *end;
+        if(elements[i].message)
+            end = elements[i].message->encodeTo(ptr + 4);
+        else
+            end = elements[i].bundle->encodeTo(ptr + 4);
+        word = BigEndian((uint32_t)(end - ptr - 4));
+        memcpy(sizeField, &word, 4);
+        ptr = end;
+    }
+    return ptr;
+}
+
+/*=============================================================================
+    ERROR HANDLING
+=============================================================================*/
+
+bool OSCBundle::hasError()
+{
+    bool retError = error != OSC_OK;
+    for(int i = 0; i < elementCount; i++)
+    {
+        if(elements[i].message)
+            retError |= elements[i].message->hasError();
+        else
+            retError |= elements[i].bundle->hasError();
+    }
+    return retError;
+}
+
+/*=============================================================================
+    BUNDLE VIEW
+=============================================================================*/
+
+static uint32_t readWord(const uint8_t *p)
+{
+    uint32_t u;
+    memcpy(&u, p, 4);
+    return BigEndian(u);
+}
+
+OSCBundleView::OSCBundleView()
+{
+    buffer = NULL;
+    length = 0;
+    cursor = 0;
+    error  = INVALID_OSC;
+}
+
+OSCBundleView::OSCBundleView(const uint8_t *packet, int packetLength)
+{
+    parse(packet, packetLength);
+}
+
+bool OSCBundleView::isBundle(const uint8_t *packet, int packetLength)
+{
+    return packetLength >= 16 && memcmp(packet, bundleTag, 8) == 0;
+}
+
+OSCErrorCode OSCBundleView::parse(const uint8_t *packet, int packetLength)
+{
+    buffer = packet;
+    length = packetLength;
+    cursor = 16;
+    // elements are 4-byte aligned so the whole bundle is too
+    if(!isBundle(packet, packetLength) || (packetLength & 3) != 0)
+    {
+        error = INVALID_OSC;
+    }
+    else
+    {
+        error = OSC_OK;
+    }
+    return error;
+}
+
+osctime_t OSCBundleView::getTimetag()
+{
+    osctime_t t = {0, 0};
+    if(!hasError())
+    {
+        t.seconds           = readWord(buffer + 8);
+        t.fractionofseconds = readWord(buffer + 12);
+    }
+    return t;
+}
+
+bool OSCBundleView::next(const uint8_t **element, int *elementLength)
+{
+    if(hasError() || cursor + 4 > length)
+    {
+        return false;
+    }
+    uint32_t size = readWord(buffer + cursor);
+    if((size & 3) != 0 || size > (uint32_t)(length - cursor - 4))
+    {
+        error = INVALID_OSC;
+        return false;
+    }
+    *element       = buffer + cursor + 4;
+    *elementLength = size;
+    cursor += 4 + size;
+    return true;
+}
+
+int OSCBundleView::forEach(void (*callback)(OSCMessageView &, osctime_t, void *),
+                           void *context)
+{
+    return forEach(callback, context, 0);
+}
+
+int OSCBundleView::forEach(void (*callback)(OSCMessageView &, osctime_t, void *),
+                           void *context,
+                           int   depth)
+{
+    if(hasError())
+    {
+        return -1;
+    }
+    // a packet of nested headers would otherwise exhaust the stack
+    if(depth >= OSC_BUNDLE_MAX_DEPTH)
+    {
+        error = INVALID_OSC;
+        return -1;
+    }
+    osctime_t      time  = getTimetag();
+    int            count = 0;
+    const uint8_t *element;
+    int            elementLength;
+    rewind();
+    while(next(&element, &elementLength))
+    {
+        if(isBundle(element, elementLength))
+        {
+            OSCBundleView nested(element, elementLength);
+            int           nestedCount
+                = nested.forEach(callback, context, depth + 1);
+            if(nestedCount < 0)
+            {
+                error = nested.getError();
+                return -1;
+            }
+            count += nestedCount;
+        }
+        else
+        {
+            OSCMessageView msg(element, elementLength);
+            if(msg.hasError())
+            {
+                return -1;
+            }
+            callback(msg, time, context);
+            count++;
+        }
+    }
+    return hasError() ? -1 : count;
+}
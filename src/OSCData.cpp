@@ -6,11 +6,12 @@ osctime_t zerotime = {0, 0};
 
 OSCData::OSCData(const char *s)
 {
-    error = OSC_OK;
-    type  = 's';
-    bytes = (strlen(s) + 1);
+    error    = OSC_OK;
+    borrowed = false;
+    type     = 's';
+    bytes    = (strlen(s) + 1);
     // own the data
-    char *mem = (char *)malloc(bytes);
+    char *mem = (char *)oscAlloc(bytes);
     if(mem == NULL)
     {
         error = ALLOCFAILED;
@@ -18,42 +19,40 @@ OSCData::OSCData(const char *s)
     else
     {
         strcpy(mem, s);
-        data.s = mem;
     }
+    // a failed allocation leaves a NULL pointer which is safe to free
+    data.s = mem;
 }
 
 OSCData::OSCData(int32_t i)
 {
-    error  = OSC_OK;
-    type   = 'i';
-    bytes  = 4;
-    data.i = i;
-}
-OSCData::OSCData(int i)
-{
-    error  = OSC_OK;
-    type   = 'i';
-    bytes  = 4;
-    data.i = i;
+    error    = OSC_OK;
+    borrowed = false;
+    type     = 'i';
+    bytes    = 4;
+    data.i   = i;
 }
 OSCData::OSCData(float f)
 {
-    error  = OSC_OK;
-    type   = 'f';
-    bytes  = 4;
-    data.f = f;
+    error    = OSC_OK;
+    borrowed = false;
+    type     = 'f';
+    bytes    = 4;
+    data.f   = f;
 }
 OSCData::OSCData(osctime_t t)
 {
     error     = OSC_OK;
+    borrowed  = false;
     type      = 't';
     bytes     = 8;
     data.time = t;
 }
 OSCData::OSCData(double d)
 {
-    error = OSC_OK;
-    bytes = sizeof(double);
+    error    = OSC_OK;
+    borrowed = false;
+    bytes    = sizeof(double);
     // if it's not 8 bytes it's not a true double
     if(bytes == 8)
     {
@@ -68,9 +67,10 @@ OSCData::OSCData(double d)
 }
 OSCData::OSCData(uint8_t *b, int len)
 {
-    error = OSC_OK;
-    type  = 'b';
-    bytes = len + 4;
+    error    = OSC_OK;
+    borrowed = false;
+    type     = 'b';
+    bytes    = len + 4;
     // add the size to the front of the blob
     uint32_t len32 = (uint32_t)len;
     // make sure the length is endian-safe
@@ -79,7 +79,7 @@ OSCData::OSCData(uint8_t *b, int len)
     // own the data
     if(bytes > 0)
     {
-        uint8_t *mem = (uint8_t *)malloc(bytes);
+        uint8_t *mem = (uint8_t *)oscAlloc(bytes);
         if(mem == NULL)
         {
             error = ALLOCFAILED;
@@ -88,10 +88,13 @@ OSCData::OSCData(uint8_t *b, int len)
         {
             // copy over the blob length
             memcpy(mem, lenPtr, 4);
-            // copy over the blob data
-            memcpy(mem + 4, b, len);
-            data.b = mem;
+            // copy over the blob data, if there is any yet
+            if(b != NULL)
+            {
+                memcpy(mem + 4, b, len);
+            }
         }
+        data.b = mem;
     }
     else
         data.b = 0;
@@ -99,10 +102,16 @@ OSCData::OSCData(uint8_t *b, int len)
 
 OSCData::OSCData(OSCData *datum)
 {
-    error = OSC_OK;
-    type  = datum->type;
-    bytes = datum->bytes;
-    if((type == 'i') || (type == 'f') || (type == 'd') || (type == 't')
+    error    = OSC_OK;
+    borrowed = datum->borrowed;
+    type     = datum->type;
+    bytes    = datum->bytes;
+    // the clone borrows the same content
+    if(borrowed)
+    {
+        data = datum->data;
+    }
+    else if((type == 'i') || (type == 'f') || (type == 'd') || (type == 't')
        || (type == 'h') || (type == 'c') || (type == 'r') || (type == 'm'))
     {
         data = datum->data;
@@ -110,7 +119,7 @@ OSCData::OSCData(OSCData *datum)
     else if((type == 's') || (type == 'b'))
     {
         // allocate a new piece of memory
-        uint8_t *mem = (uint8_t *)malloc(bytes);
+        uint8_t *mem = (uint8_t *)oscAlloc(bytes);
         if(mem == NULL)
         {
             error = ALLOCFAILED;
@@ -119,22 +128,31 @@ OSCData::OSCData(OSCData *datum)
         {
             // copy over the blob length
             memcpy(mem, datum->data.b, bytes);
-            data.b = mem;
         }
+        data.b = mem;
     }
 }
 
+OSCData::OSCData(uint8_t *content, uint32_t length, bool)
+{
+    error    = OSC_OK;
+    borrowed = true;
+    type     = 'b';
+    bytes    = (int)length + 4;
+    data.b   = content;
+}
+
 // DESTRUCTOR
 OSCData::~OSCData()
 {
     // if there are no bytes, there is nothing to free
-    if(bytes > 0)
+    if(bytes > 0 && !borrowed)
     {
         // if the data is of type 's' or 'b', need to free that memory
         if(type == 's')
-            free(data.s);
+            oscFree(data.s);
         else if(type == 'b')
-            free(data.b);
+            oscFree(data.b);
     }
 }
 
@@ -142,9 +160,10 @@ OSCData::~OSCData()
 // no data
 OSCData::OSCData(char t)
 {
-    error = INVALID_OSC;
-    type  = t;
-    bytes = 0;
+    error    = INVALID_OSC;
+    borrowed = false;
+    type     = t;
+    bytes    = 0;
 }
 
 /*=============================================================================
@@ -238,9 +257,9 @@ int OSCData::getBlob(uint8_t *blobBuffer)
     // read the blob length
     int blobLength = getBlobLength();
 
-    if(type == 'b')
+    if(type == 'b' && getBlobContent() != NULL)
     {
-        memcpy(blobBuffer, data.b + 4, blobLength);
+        memcpy(blobBuffer, getBlobContent(), blobLength);
         return blobLength;
     }
     else
@@ -253,9 +272,9 @@ int OSCData::getBlob(uint8_t *blobBuffer, int length)
 {
     // jump over the first 4 bytes which encode the length
     int blobLength = bytes - 4;
-    if(type == 'b' && blobLength <= length)
+    if(type == 'b' && blobLength <= length && getBlobContent() != NULL)
     {
-        memcpy(blobBuffer, data.b + 4, blobLength);
+        memcpy(blobBuffer, getBlobContent(), blobLength);
         return blobLength;
     }
     else
@@ -267,9 +286,10 @@ int OSCData::getBlob(uint8_t *blobBuffer, int length, int offset, int size)
 {
     // jump over the first 4 bytes which encode the length
     int blobLength = bytes - 4;
-    if(type == 'b' && size <= blobLength && size <= length)
+    if(type == 'b' && size <= blobLength && size <= length
+       && getBlobContent() != NULL)
     {
-        memcpy(blobBuffer, data.b + 4 + offset, size);
+        memcpy(blobBuffer, getBlobContent() + offset, size);
         return size;
     }
     else
@@ -282,4 +302,12 @@ int OSCData::getBlobLength()
         // jump over the first 4 bytes which encode the length
         return bytes - 4;
     return -1;
-}
\ No newline at end of file
+}
+
+uint8_t *OSCData::getBlobContent()
+{
+    if(type != 'b' || data.b == NULL)
+        return NULL;
+    // owned blobs keep their length in front
+    return borrowed ? data.b : data.b + 4;
+}
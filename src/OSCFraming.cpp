@@ -0,0 +1,382 @@
+#include "OSCFraming.h"
+
+#include <string.h>
+
+/*=============================================================================
+    SLIP
+ =============================================================================*/
+
+size_t oscSlipEncode(const uint8_t *packet,
+                     size_t         length,
+                     uint8_t       *out,
+                     size_t         outSize)
+{
+    // the two ENDs, and one more byte for every byte that is escaped
+    size_t frameLength = length + 2;
+    for(size_t i = 0; i < length; i++)
+    {
+        if(packet[i] == OSC_SLIP_END || packet[i] == OSC_SLIP_ESC)
+        {
+            frameLength++;
+        }
+    }
+    if(frameLength > outSize)
+    {
+        return frameLength;
+    }
+    *out++ = OSC_SLIP_END;
+    for(size_t i = 0; i < length; i++)
+    {
+        uint8_t byte = packet[i];
+        if(byte == OSC_SLIP_END)
+        {
+            *out++ = OSC_SLIP_ESC;
+            *out++ = OSC_SLIP_ESC_END;
+        }
+        else if(byte == OSC_SLIP_ESC)
+        {
+            *out++ = OSC_SLIP_ESC;
+            *out++ = OSC_SLIP_ESC_ESC;
+        }
+        else
+        {
+            *out++ = byte;
+        }
+    }
+    *out = OSC_SLIP_END;
+    return frameLength;
+}
+
+OSCSlipDecoder::OSCSlipDecoder(uint8_t          *_buffer,
+                               size_t            _bufferSize,
+                               OSCPacketCallback _callback,
+                               void             *_context)
+{
+    buffer      = _buffer;
+    bufferSize  = _bufferSize;
+    callback    = _callback;
+    context     = _context;
+    packetCount = 0;
+    errorCount  = 0;
+    reset();
+}
+
+void OSCSlipDecoder::reset()
+{
+    length     = 0;
+    escaped    = false;
+    discarding = false;
+}
+
+void OSCSlipDecoder::endFrame()
+{
+    // back to back ENDs make empty frames, which are not packets
+    if(!discarding && !escaped && length > 0)
+    {
+        packetCount++;
+        callback(buffer, length, context);
+    }
+    else if(escaped)
+    {
+        errorCount++;
+    }
+    reset();
+}
+
+void OSCSlipDecoder::decode(uint8_t byte)
+{
+    if(byte == OSC_SLIP_END)
+    {
+        endFrame();
+        return;
+    }
+    if(discarding)
+    {
+        return;
+    }
+    if(escaped)
+    {
+        escaped = false;
+        if(byte == OSC_SLIP_ESC_END)
+        {
+            byte = OSC_SLIP_END;
+        }
+        else if(byte == OSC_SLIP_ESC_ESC)
+        {
+            byte = OSC_SLIP_ESC;
+        }
+        else
+        {
+            // not a valid escape, skip to the next frame
+            errorCount++;
+            discarding = true;
+            return;
+        }
+    }
+    else if(byte == OSC_SLIP_ESC)
+    {
+        escaped = true;
+        return;
+    }
+    if(length == bufferSize)
+    {
+        // the packet doesn't fit, skip to the next frame
+        errorCount++;
+        discarding = true;
+        return;
+    }
+    buffer[length++] = byte;
+}
+
+void OSCSlipDecoder::decode(const uint8_t *bytes, size_t count)
+{
+    while(count > 0)
+    {
+        if(discarding || escaped)
+        {
+            decode(*bytes++);
+            count--;
+            continue;
+        }
+        // copy the run of plain bytes up to the next special one
+        size_t run = 0;
+        while(run < count && bytes[run] != OSC_SLIP_END
+              && bytes[run] != OSC_SLIP_ESC)
+        {
+            run++;
+        }
+        if(run > bufferSize - length)
+        {
+            // the packet doesn't fit, skip to the next frame
+            errorCount++;
+            discarding = true;
+        }
+        else
+        {
+            memcpy(buffer + length, bytes, run);
+            length += run;
+        }
+        bytes += run;
+        count -= run;
+        if(count > 0)
+        {
+            decode(*bytes++);
+            count--;
+        }
+    }
+}
+
+/*=============================================================================
+    LENGTH PREFIX
+ =============================================================================*/
+
+OSCLengthDecoder::OSCLengthDecoder(uint8_t          *_buffer,
+                                   size_t            _bufferSize,
+                                   OSCPacketCallback _callback,
+                                   OSCAcceptCallback _accept,
+                                   void             *_context)
+{
+    buffer      = _buffer;
+    bufferSize  = _bufferSize;
+    callback    = _callback;
+    accept      = _accept;
+    context     = _context;
+    packetCount = 0;
+    skipCount   = 0;
+    errorCount  = 0;
+    reset();
+}
+
+void OSCLengthDecoder::reset()
+{
+    length       = 0;
+    headerLength = 0;
+    remaining    = 0;
+    skipping     = false;
+}
+
+void OSCLengthDecoder::beginPacket()
+{
+    uint32_t size;
+    memcpy(&size, header, 4);
+    size = BigEndian(size);
+    if(size == 0 || (size & 3) != 0)
+    {
+        // not a packet size, try again one byte further
+        errorCount++;
+        memmove(header, header + 1, 3);
+        headerLength = 3;
+        return;
+    }
+    headerLength = 0;
+    length       = 0;
+    remaining    = size;
+    skipping     = size > bufferSize
+               || (accept != NULL && !accept(size, context));
+    if(skipping)
+    {
+        skipCount++;
+    }
+}
+
+void OSCLengthDecoder::decode(uint8_t byte)
+{
+    decode(&byte, 1);
+}
+
+void OSCLengthDecoder::decode(const uint8_t *bytes, size_t count)
+{
+    while(count > 0)
+    {
+        if(remaining == 0)
+        {
+            header[headerLength++] = *bytes++;
+            count--;
+            if(headerLength == 4)
+            {
+                beginPacket();
+            }
+            continue;
+        }
+        // the rest of the packet, or as much of it as has arrived
+        size_t run = remaining < count ? remaining : count;
+        if(!skipping)
+        {
+            memcpy(buffer + length, bytes, run);
+            length += run;
+        }
+        bytes += run;
+        count -= run;
+        remaining -= run;
+        if(remaining == 0 && !skipping)
+        {
+            packetCount++;
+            callback(buffer, length, context);
+        }
+    }
+}
+
+/*=============================================================================
+    STREAM DECODING
+ =============================================================================*/
+
+OSCStreamDecoder::OSCStreamDecoder(uint8_t           *scratch,
+                                   int                scratchSize,
+                                   OSCMessageCallback _callback,
+                                   void              *_context)
+{
+    message.setIncomingBuffer(scratch, scratchSize);
+    callback     = _callback;
+    context      = _context;
+    messageCount = 0;
+    skipCount    = 0;
+    errorCount   = 0;
+    reset();
+}
+
+void OSCStreamDecoder::reset()
+{
+    message.empty();
+    headerLength = 0;
+    remaining    = 0;
+    starting     = false;
+    skipping     = false;
+}
+
+void OSCStreamDecoder::beginMessage()
+{
+    uint32_t size;
+    memcpy(&size, header, 4);
+    size = BigEndian(size);
+    if(size == 0 || (size & 3) != 0)
+    {
+        // not a packet size, try again one byte further
+        errorCount++;
+        memmove(header, header + 1, 3);
+        headerLength = 3;
+        return;
+    }
+    message.empty();
+    headerLength = 0;
+    remaining    = size;
+    starting     = true;
+    skipping     = false;
+}
+
+void OSCStreamDecoder::endMessage()
+{
+    // the byte decoder can't tell where a message ends, so the last
+    // argument must have been decoded when the size runs out
+    bool complete = message.decodeState == OSCMessage::DONE
+                    || message.decodeState == OSCMessage::ADDRESS_PADDING
+                    || ((message.decodeState == OSCMessage::DATA
+                         || message.decodeState == OSCMessage::DATA_PADDING)
+                        && message.decodeIndex >= message.dataCount
+                        && message.blobRemaining == 0);
+    // and its padding too, it is waited for in DATA_PADDING
+    if(complete && message.decodeState == OSCMessage::DATA_PADDING
+       && message.decodeIndex > 0)
+    {
+        OSCData *datum = message.getOSCData(message.decodeIndex - 1);
+        int      pad   = message.padSize(datum->bytes);
+        complete       = pad == 0 || message.incomingBufferSize == pad;
+    }
+    if(!complete || message.hasError())
+    {
+        errorCount++;
+        return;
+    }
+    message.decodeState = OSCMessage::DONE;
+    messageCount++;
+    callback(message, context);
+}
+
+void OSCStreamDecoder::decode(uint8_t byte)
+{
+    decode(&byte, 1);
+}
+
+void OSCStreamDecoder::decode(const uint8_t *bytes, size_t count)
+{
+    while(count > 0)
+    {
+        if(remaining == 0)
+        {
+            header[headerLength++] = *bytes++;
+            count--;
+            if(headerLength == 4)
+            {
+                beginMessage();
+            }
+            continue;
+        }
+        if(starting)
+        {
+            starting = false;
+            // bundles need a bundle to be decoded into
+            if(*bytes == '#')
+            {
+                skipping = true;
+                skipCount++;
+            }
+        }
+        // the rest of the message, or as much of it as has arrived
+        size_t run = remaining < count ? remaining : count;
+        if(!skipping)
+        {
+            message.fill((uint8_t *)bytes, (int)run);
+            if(message.getError() == BUFFER_FULL)
+            {
+                skipping = true;
+                skipCount++;
+            }
+        }
+        bytes += run;
+        count -= run;
+        remaining -= run;
+        if(remaining == 0 && !skipping)
+        {
+            endMessage();
+        }
+    }
+}
@@ -284,4 +284,279 @@ static int osc_match_curly_brace(const char *pattern, const char *address)
 		}
 	}
 	return 0;
-}
\ No newline at end of file
+}
+/*
+ * Compiled patterns
+ *
+ * The program is a list of components separated by OSC_OP_SEP, each one a list
+ * of tokens. A component is matched against an address component by tracking
+ * the set of address positions reachable after each token, so stars never
+ * need recursion or backtracking.
+ */
+
+#define OSC_OP_END 0
+#define OSC_OP_SEP 1
+#define OSC_OP_LITERAL 2 // followed by a length and the characters
+#define OSC_OP_ANY 3
+#define OSC_OP_CLASS 4 // followed by the index of the class
+#define OSC_OP_ALT 5 // followed by a count and that many length-prefixed alternatives
+#define OSC_OP_STAR 6
+
+#define OSC_PATTERN_WORDS ((OSC_PATTERN_MAX_COMPONENT + 64) / 64)
+
+int osc_pattern_compile(osc_pattern *compiled, const char *pattern)
+{
+	uint8_t *code = compiled->code;
+	// keep one byte for the final OSC_OP_END
+	uint8_t *last = compiled->code + OSC_PATTERN_MAX_CODE - 1;
+	uint8_t *literal = NULL; // the length of the literal run being written
+	int num_classes = 0;
+
+	while(*pattern != '\0'){
+		char c = *pattern;
+		if(c == '/' || c == '*' || c == '?' || c == '[' || c == '{'){
+			literal = NULL;
+		}
+		switch(c){
+			case '/':
+				if(code >= last){ return 0; }
+				*code++ = OSC_OP_SEP;
+				pattern++;
+				break;
+			case '*':
+				// consecutive stars are the same as one
+				if(code == compiled->code || *(code - 1) != OSC_OP_STAR){
+					if(code >= last){ return 0; }
+					*code++ = OSC_OP_STAR;
+				}
+				pattern++;
+				break;
+			case '?':
+				if(code >= last){ return 0; }
+				*code++ = OSC_OP_ANY;
+				pattern++;
+				break;
+			case '[':
+			{
+				if(num_classes == OSC_PATTERN_MAX_CLASSES || last - code < 2){
+					return 0;
+				}
+				uint8_t *set = compiled->classes[num_classes];
+				int negate = 0;
+				int i;
+				memset(set, 0, 32);
+				pattern++;
+				if(*pattern == '!'){
+					negate = 1;
+					pattern++;
+				}
+				while(*pattern != ']'){
+					if(*pattern == '\0' || *pattern == '/'){
+						return 0;
+					}
+					uint8_t lo = (uint8_t)*pattern;
+					uint8_t hi = lo;
+					if(*(pattern + 1) == '-' && *(pattern + 2) != ']' && *(pattern + 2) != '\0'){
+						hi = (uint8_t)*(pattern + 2);
+						pattern += 2;
+					}
+					for(i = lo; i <= hi; i++){
+						set[i >> 3] |= 1 << (i & 7);
+					}
+					pattern++;
+				}
+				if(negate){
+					for(i = 0; i < 32; i++){
+						set[i] = ~set[i];
+					}
+				}
+				pattern++;
+				*code++ = OSC_OP_CLASS;
+				*code++ = num_classes++;
+			}
+				break;
+			case '{':
+			{
+				if(last - code < 2){
+					return 0;
+				}
+				*code++ = OSC_OP_ALT;
+				uint8_t *count = code++;
+				*count = 0;
+				pattern++;
+				while(1){
+					const char *start = pattern;
+					while(*pattern != ',' && *pattern != '}'){
+						if(*pattern == '\0' || *pattern == '/'){
+							return 0;
+						}
+						pattern++;
+					}
+					int n = pattern - start;
+					if(n > 255 || last - code < n + 1 || *count == 255){
+						return 0;
+					}
+					*code++ = n;
+					memcpy(code, start, n);
+					code += n;
+					(*count)++;
+					if(*pattern++ == '}'){
+						break;
+					}
+				}
+			}
+				break;
+			default:
+				// extend the current literal run or start a new one
+				if(literal == NULL || *literal == 255){
+					// the op, the length and the character
+					if(last - code < 3){
+						return 0;
+					}
+					*code++ = OSC_OP_LITERAL;
+					literal = code++;
+					*literal = 0;
+				}else if(code >= last){
+					return 0;
+				}
+				*code++ = c;
+				(*literal)++;
+				pattern++;
+				break;
+		}
+	}
+	*code = OSC_OP_END;
+	return 1;
+}
+
+static inline void osc_pattern_set(uint64_t *set, int position)
+{
+	set[position >> 6] |= (uint64_t)1 << (position & 63);
+}
+
+// returns the number of operand bytes following the opcode
+static int osc_pattern_operands(const uint8_t *code)
+{
+	switch(*code){
+		case OSC_OP_LITERAL:
+			return 1 + code[1];
+		case OSC_OP_CLASS:
+			return 1;
+		case OSC_OP_ALT:
+		{
+			int n = 1;
+			int count = code[1];
+			while(count--){
+				n += 1 + code[1 + n];
+			}
+			return n;
+		}
+		default:
+			return 0;
+	}
+}
+
+// matches the tokens at *pc against the n characters of the address component
+// leaves *pc on the OSC_OP_SEP or OSC_OP_END which follows the component
+static int osc_pattern_match_component(const osc_pattern *compiled, const uint8_t **pc, const char *address, int n)
+{
+	const uint8_t *code = *pc;
+	uint64_t reach[OSC_PATTERN_WORDS];
+	uint64_t next[OSC_PATTERN_WORDS];
+	int matched = n <= OSC_PATTERN_MAX_COMPONENT;
+	int w;
+
+	memset(reach, 0, sizeof(reach));
+	reach[0] = 1;
+	while(*code != OSC_OP_END && *code != OSC_OP_SEP){
+		if(matched){
+			memset(next, 0, sizeof(next));
+			if(*code == OSC_OP_STAR){
+				// everything from the first reachable position onwards
+				int p = 0;
+				while(!(reach[p >> 6] & ((uint64_t)1 << (p & 63)))){
+					p++;
+				}
+				for(; p <= n; p++){
+					osc_pattern_set(next, p);
+				}
+			}else{
+				for(w = 0; w < OSC_PATTERN_WORDS; w++){
+					uint64_t bits = reach[w];
+					while(bits){
+						int p = (w << 6) + __builtin_ctzll(bits);
+						bits &= bits - 1;
+						switch(*code){
+							case OSC_OP_LITERAL:
+								if(p + code[1] <= n && !memcmp(address + p, code + 2, code[1])){
+									osc_pattern_set(next, p + code[1]);
+								}
+								break;
+							case OSC_OP_ANY:
+								if(p < n){
+									osc_pattern_set(next, p + 1);
+								}
+								break;
+							case OSC_OP_CLASS:
+							{
+								uint8_t c = (uint8_t)address[p];
+								if(p < n && (compiled->classes[code[1]][c >> 3] & (1 << (c & 7)))){
+									osc_pattern_set(next, p + 1);
+								}
+							}
+								break;
+							case OSC_OP_ALT:
+							{
+								const uint8_t *alt = code + 2;
+								int count = code[1];
+								while(count--){
+									if(p + alt[0] <= n && !memcmp(address + p, alt + 1, alt[0])){
+										osc_pattern_set(next, p + alt[0]);
+									}
+									alt += 1 + alt[0];
+								}
+							}
+								break;
+						}
+					}
+				}
+			}
+			matched = 0;
+			for(w = 0; w < OSC_PATTERN_WORDS; w++){
+				reach[w] = next[w];
+				matched |= next[w] != 0;
+			}
+		}
+		code += 1 + osc_pattern_operands(code);
+	}
+	*pc = code;
+	return matched && (reach[n >> 6] & ((uint64_t)1 << (n & 63)));
+}
+
+int osc_pattern_match(const osc_pattern *compiled, const char *address, int *address_offset)
+{
+	const uint8_t *pc = compiled->code;
+	const char *address_start = address;
+
+	*address_offset = 0;
+	while(1){
+		int n = 0;
+		while(address[n] != '/' && address[n] != '\0'){
+			n++;
+		}
+		if(!osc_pattern_match_component(compiled, &pc, address, n)){
+			return 0;
+		}
+		address += n;
+		*address_offset = address - address_start;
+		if(*pc == OSC_OP_END){
+			return OSC_MATCH_PATTERN_COMPLETE | (*address == '\0' ? OSC_MATCH_ADDRESS_COMPLETE : 0);
+		}
+		// the pattern continues with a '/'
+		if(*address == '\0'){
+			return OSC_MATCH_ADDRESS_COMPLETE;
+		}
+		pc++;
+		address++;
+	}
+}
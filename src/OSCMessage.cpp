@@ -23,19 +23,30 @@ OSCMessage::OSCMessage()
 // sets up a new message
 void OSCMessage::setupMessage()
 {
-    address = NULL;
+    address        = NULL;
+    addressHash    = oscHash("");
+    addressLength  = 0;
+    addressPattern = false;
     // setup the attributes
     dataCount = 0;
     error     = OSC_OK;
     // setup the space for data
-    data = NULL;
+    data         = (OSCData *)inlineData;
+    dataCapacity = OSC_INLINE_ARGS;
     // setup for filling the message
-    incomingBuffer     = NULL;
-    incomingBufferSize = 0;
-    incomingBufferFree = 0;
+    incomingBuffer      = NULL;
+    incomingBufferSize  = 0;
+    incomingBufferFree  = 0;
+    incomingBufferFixed = false;
     clearIncomingBuffer();
     // set the decode state
     decodeState = STANDBY;
+    decodeIndex = 0;
+    // no blob streaming
+    blobHandler        = NULL;
+    blobHandlerContext = NULL;
+    blobRemaining      = 0;
+    blobOffset         = 0;
 }
 
 // DESTRUCTOR
@@ -43,11 +54,14 @@ OSCMessage::~OSCMessage()
 {
     // free everything that needs to be freed
     // free the address
-    free(address);
+    oscFree(address);
     // free the data
     empty();
     // free the filling buffer
-    free(incomingBuffer);
+    if(!incomingBufferFixed)
+    {
+        oscFree(incomingBuffer);
+    }
 }
 
 OSCMessage &OSCMessage::empty()
@@ -56,16 +70,21 @@ OSCMessage &OSCMessage::empty()
     // free each of the data in the array
     for(int i = 0; i < dataCount; i++)
     {
-        OSCData *datum = getOSCData(i);
-        // explicitly destruct the data
-        // datum->~OSCData();
-        delete datum;
-    }
-    // and free the array
-    free(data);
-    data        = NULL;
-    dataCount   = 0;
-    decodeState = STANDBY;
+        // explicitly destruct the data, the slot itself stays in the array
+        data[i].~OSCData();
+    }
+    // and free the array if it was moved to the heap
+    if(data != (OSCData *)inlineData)
+    {
+        oscFree(data);
+    }
+    data         = (OSCData *)inlineData;
+    dataCapacity = OSC_INLINE_ARGS;
+    dataCount    = 0;
+    decodeState  = STANDBY;
+    decodeIndex  = 0;
+    // a blob cut off by emptying is abandoned
+    blobRemaining = 0;
     clearIncomingBuffer();
     return *this;
 }
@@ -79,10 +98,41 @@ OSCMessage::OSCMessage(OSCMessage *msg)
     // add each of the data to the other message
     for(int i = 0; i < msg->dataCount; i++)
     {
-        add(msg->data[i]);
+        add(&msg->data[i]);
     }
 }
 
+OSCData *OSCMessage::reserveSlot()
+{
+    if(dataCount < dataCapacity)
+    {
+        return &data[dataCount];
+    }
+    // double the capacity, slots own no self-references so they can be moved bytewise
+    int      newCapacity = dataCapacity * 2;
+    OSCData *dataMem;
+    if(data == (OSCData *)inlineData)
+    {
+        dataMem = (OSCData *)oscAlloc(sizeof(OSCData) * newCapacity);
+        if(dataMem != NULL)
+        {
+            memcpy((void *)dataMem, inlineData, sizeof(OSCData) * dataCount);
+        }
+    }
+    else
+    {
+        dataMem = (OSCData *)oscRealloc(
+            (void *)data, sizeof(OSCData) * newCapacity);
+    }
+    if(dataMem == NULL)
+    {
+        return NULL;
+    }
+    data         = dataMem;
+    dataCapacity = newCapacity;
+    return &data[dataCount];
+}
+
 /*=============================================================================
   GETTING DATA
 =============================================================================*/
@@ -91,8 +141,7 @@ OSCData *OSCMessage::getOSCData(int position)
 {
     if(position < dataCount)
     {
-        OSCData *datum = data[position];
-        return datum;
+        return &data[position];
     }
     else
     {
@@ -301,6 +350,7 @@ bool OSCMessage::isBoolean(int position)
 
 int OSCMessage::match(const char *pattern, int addr_offset)
 {
+    OSC_PROFILE_STAGE(OSC_STAGE_MATCH);
     int pattern_offset;
     int address_offset;
     int ret = osc_match(
@@ -322,6 +372,7 @@ int OSCMessage::match(const char *pattern, int addr_offset)
 
 bool OSCMessage::fullMatch(const char *pattern, int addr_offset)
 {
+    OSC_PROFILE_STAGE(OSC_STAGE_MATCH);
     int pattern_offset;
     int address_offset;
     int ret = osc_match(
@@ -333,6 +384,7 @@ bool OSCMessage::dispatch(const char *pattern,
                           void (*callback)(OSCMessage &),
                           int addr_offset)
 {
+    OSC_PROFILE_STAGE(OSC_STAGE_DISPATCH);
     if(fullMatch(pattern, addr_offset))
     {
         callback(*this);
@@ -348,6 +400,69 @@ bool OSCMessage::route(const char *pattern,
                        void (*callback)(OSCMessage &, int),
                        int initial_offset)
 {
+    OSC_PROFILE_STAGE(OSC_STAGE_DISPATCH);
+    int match_offset = match(pattern, initial_offset);
+    if(match_offset > 0)
+    {
+        callback(*this, match_offset + initial_offset);
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+int OSCMessage::match(const osc_pattern *pattern, int addr_offset)
+{
+    OSC_PROFILE_STAGE(OSC_STAGE_MATCH);
+    int address_offset;
+    int ret = osc_pattern_match(pattern, address + addr_offset, &address_offset);
+    char *next = (char *)(address + addr_offset + address_offset);
+    if(ret == 3)
+    {
+        return address_offset;
+    }
+    else if((ret & OSC_MATCH_PATTERN_COMPLETE) && address_offset > 0
+            && *next == '/')
+    {
+        return address_offset;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+bool OSCMessage::fullMatch(const osc_pattern *pattern, int addr_offset)
+{
+    OSC_PROFILE_STAGE(OSC_STAGE_MATCH);
+    int address_offset;
+    int ret = osc_pattern_match(pattern, address + addr_offset, &address_offset);
+    return (ret == 3);
+}
+
+bool OSCMessage::dispatch(const osc_pattern *pattern,
+                          void (*callback)(OSCMessage &),
+                          int addr_offset)
+{
+    OSC_PROFILE_STAGE(OSC_STAGE_DISPATCH);
+    if(fullMatch(pattern, addr_offset))
+    {
+        callback(*this);
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool OSCMessage::route(const osc_pattern *pattern,
+                       void (*callback)(OSCMessage &, int),
+                       int initial_offset)
+{
+    OSC_PROFILE_STAGE(OSC_STAGE_DISPATCH);
     int match_offset = match(pattern, initial_offset);
     if(match_offset > 0)
     {
@@ -379,9 +494,10 @@ int OSCMessage::getAddress(char *buffer, int offset, int len)
 OSCMessage &OSCMessage::setAddress(const char *_address)
 {
     // free the previous address
-    free(address); // are we sure address was allocated?
-                   // copy the address
-    char *addressMemory = (char *)malloc((strlen(_address) + 1) * sizeof(char));
+    oscFree(address); // are we sure address was allocated?
+                      // copy the address
+    char *addressMemory
+        = (char *)oscAlloc((strlen(_address) + 1) * sizeof(char));
     if(addressMemory == NULL)
     {
         error   = ALLOCFAILED;
@@ -392,6 +508,16 @@ OSCMessage &OSCMessage::setAddress(const char *_address)
         strcpy(addressMemory, _address);
         address = addressMemory;
     }
+    // hash the address and look for pattern characters in the same pass
+    addressHash    = OSC_HASH_BASIS;
+    addressLength  = 0;
+    addressPattern = false;
+    for(const char *c = address; c != NULL && *c != '\0'; c++)
+    {
+        addressHash = (addressHash ^ (uint8_t)*c) * OSC_HASH_PRIME;
+        addressPattern |= *c == '*' || *c == '?' || *c == '[' || *c == '{';
+        addressLength++;
+    }
     return *this;
 }
 
@@ -435,6 +561,111 @@ int OSCMessage::bytes()
     return messageSize;
 }
 
+/*=============================================================================
+    ENCODING
+=============================================================================*/
+
+int OSCMessage::encode(uint8_t *buffer, size_t bufferSize)
+{
+    if(hasError())
+    {
+        return 0;
+    }
+    int messageSize = bytes();
+    if(buffer == NULL || (size_t)messageSize > bufferSize)
+    {
+        return messageSize;
+    }
+    encodeTo(buffer);
+    return messageSize;
+}
+
+// writes the zeros which pad a field of that length to 4 bytes
+static inline uint8_t *writePadding(uint8_t *ptr, int length)
+{
+    int pad = (4 - (length & 3)) & 3;
+    while(pad--)
+    {
+        *ptr++ = 0;
+    }
+    return ptr;
+}
+
+uint8_t *OSCMessage::encodeTo(uint8_t *ptr)
+{
+    // the address
+    int addrLen = strlen(address) + 1;
+    memcpy(ptr, address, addrLen);
+    ptr = writePadding(ptr + addrLen, addrLen);
+
+    // the comma and the types
+    *ptr++ = ',';
+    for(int i = 0; i < dataCount; i++)
+    {
+        *ptr++ = data[i].type;
+    }
+    // the type string has to be null terminated
+    *ptr++ = 0;
+    ptr    = writePadding(ptr, dataCount + 2);
+
+    // the data
+    for(int i = 0; i < dataCount; i++)
+    {
+        OSCData *datum = &data[i];
+        switch(datum->type)
+        {
+            case 's':
+            case 'b':
+                if(datum->borrowed)
+                {
+                    // the content doesn't carry its length
+                    uint32_t length = BigEndian((uint32_t)datum->bytes - 4);
+                    memcpy(ptr, &length, 4);
+                    if(datum->data.b != NULL)
+                    {
+                        memcpy(ptr + 4, datum->data.b, datum->bytes - 4);
+                    }
+                    else
+                    {
+                        memset(ptr + 4, 0, datum->bytes - 4);
+                    }
+                }
+                else
+                {
+                    memcpy(ptr, datum->data.b, datum->bytes);
+                }
+                ptr = writePadding(ptr + datum->bytes, datum->bytes);
+                break;
+            case 'd':
+            {
+                double d = BigEndian(datum->data.d);
+                memcpy(ptr, &d, 8);
+                ptr += 8;
+            }
+            break;
+            case 't':
+            {
+                uint32_t d = BigEndian(datum->data.time.seconds);
+                memcpy(ptr, &d, 4);
+                d = BigEndian(datum->data.time.fractionofseconds);
+                memcpy(ptr + 4, &d, 4);
+                ptr += 8;
+            }
+            break;
+            case 'T':
+            case 'F': break;
+            default:
+            { // float or int
+                uint32_t i = BigEndian(datum->data.i);
+                memcpy(ptr, &i, datum->bytes);
+                ptr += datum->bytes;
+            }
+            break;
+        }
+    }
+    return ptr;
+}
+
 /*=============================================================================
     ERROR HANDLING
 =============================================================================*/
@@ -462,19 +693,66 @@ OSCErrorCode OSCMessage::getError()
 
 OSCMessage &OSCMessage::fill(uint8_t incomingByte)
 {
+    OSC_PROFILE_STAGE(OSC_STAGE_DECODE);
     decode(incomingByte);
     return *this;
 }
 
 OSCMessage &OSCMessage::fill(uint8_t *incomingBytes, int length)
 {
-    while(length--)
+    OSC_PROFILE_STAGE(OSC_STAGE_DECODE);
+    // nothing buffered yet, try to decode the whole message at once
+    if(decodeState == STANDBY && incomingBufferSize == 0
+       && decodeBlock(incomingBytes, length) > 0)
+    {
+        decodeState = DONE;
+        return *this;
+    }
+    while(length > 0)
     {
+        // a streamed blob's content goes to its sink in one piece
+        if(blobRemaining > 0)
+        {
+            int n = blobRemaining < (uint32_t)length ? (int)blobRemaining
+                                                      : length;
+            streamBlob(incomingBytes, n);
+            incomingBytes += n;
+            length -= n;
+            continue;
+        }
         decode(*incomingBytes++);
+        length--;
     }
     return *this;
 }
 
+void OSCMessage::setBlobHandler(OSCBlobHandler handler, void *context)
+{
+    blobHandler        = handler;
+    blobHandlerContext = context;
+}
+
+void OSCMessage::setIncomingBuffer(uint8_t *buffer, int size)
+{
+    if(!incomingBufferFixed)
+    {
+        oscFree(incomingBuffer);
+    }
+    incomingBuffer      = NULL;
+    incomingBufferSize  = 0;
+    incomingBufferFree  = 0;
+    incomingBufferFixed = buffer != NULL;
+    if(incomingBufferFixed)
+    {
+        incomingBuffer     = buffer;
+        incomingBufferFree = size;
+    }
+    else
+    {
+        clearIncomingBuffer();
+    }
+}
+
 /*=============================================================================
     DECODING
  =============================================================================*/
@@ -493,120 +771,466 @@ void OSCMessage::decodeType(uint8_t incomingByte)
     add(type);
 }
 
-void OSCMessage::decodeData(uint8_t incomingByte)
+void OSCMessage::skipEmptyData()
 {
-    // get the first OSCData to re-set
-    for(int i = 0; i < dataCount; i++)
+    while(decodeIndex < dataCount)
     {
-        OSCData *datum = getOSCData(i);
-        if(datum->error == INVALID_OSC)
+        OSCData *datum = getOSCData(decodeIndex);
+        if(datum->type != 'T' && datum->type != 'F' && datum->type != 'N'
+           && datum->type != 'I')
         {
-            // set the contents of datum with the data received
-            switch(datum->type)
+            break;
+        }
+        // the type is all there is to decode
+        datum->error = OSC_OK;
+        decodeIndex++;
+    }
+}
+
+void OSCMessage::decodeData(uint8_t incomingByte)
+{
+    OSC_PROFILE_STAGE(OSC_STAGE_DECODE_DATA);
+    // the first OSCData which has not been set yet
+    if(decodeIndex >= dataCount)
+    {
+        return;
+    }
+    int      i     = decodeIndex;
+    OSCData *datum = getOSCData(i);
+    // set the contents of datum with the data received
+    switch(datum->type)
+    {
+        case 'i':
+            if(incomingBufferSize == 4)
+            {
+                // parse the buffer as an int
+                union
+                {
+                    int32_t i;
+                    uint8_t b[4];
+                } u;
+                memcpy(u.b, incomingBuffer, 4);
+                int32_t dataVal = BigEndian(u.i);
+                set(i, dataVal);
+                clearIncomingBuffer();
+            }
+            break;
+        case 'f':
+            if(incomingBufferSize == 4)
+            {
+                // parse the buffer as a float
+                union
+                {
+                    float   f;
+                    uint8_t b[4];
+                } u;
+                memcpy(u.b, incomingBuffer, 4);
+                float dataVal = BigEndian(u.f);
+                set(i, dataVal);
+                clearIncomingBuffer();
+            }
+            break;
+        case 'd':
+            if(incomingBufferSize == 8)
+            {
+                // parse the buffer as a double
+                union
+                {
+                    double  d;
+                    uint8_t b[8];
+                } u;
+                memcpy(u.b, incomingBuffer, 8);
+                double dataVal = BigEndian(u.d);
+                set(i, dataVal);
+                clearIncomingBuffer();
+            }
+            break;
+        case 't':
+            if(incomingBufferSize == 8)
             {
-                case 'i':
-                    if(incomingBufferSize == 4)
+                // parse the buffer as a timetag
+                union
+                {
+                    osctime_t t;
+                    uint8_t   b[8];
+                } u;
+                memcpy(u.b, incomingBuffer, 8);
+
+                u.t.seconds           = BigEndian(u.t.seconds);
+                u.t.fractionofseconds = BigEndian(u.t.fractionofseconds);
+                set(i, u.t);
+                clearIncomingBuffer();
+            }
+            break;
+
+        case 's':
+            if(incomingByte == 0)
+            {
+                char *str = (char *)incomingBuffer;
+                set(i, str);
+                clearIncomingBuffer();
+                decodeState = DATA_PADDING;
+            }
+            break;
+        case 'b':
+            if(incomingBufferSize == 4
+               && (blobHandler != NULL || incomingBufferFixed))
+            {
+                uint32_t length;
+                memcpy(&length, incomingBuffer, 4);
+                if(openBlob(BigEndian(length), i))
+                {
+                    clearIncomingBuffer();
+                    // an empty blob is complete already
+                    if(blobRemaining == 0)
                     {
-                        // parse the buffer as an int
-                        union
-                        {
-                            int32_t i;
-                            uint8_t b[4];
-                        } u;
-                        memcpy(u.b, incomingBuffer, 4);
-                        int32_t dataVal = BigEndian(u.i);
-                        set(i, dataVal);
-                        clearIncomingBuffer();
+                        decodeState = DATA_PADDING;
                     }
-                    break;
-                case 'f':
-                    if(incomingBufferSize == 4)
+                    else
                     {
-                        // parse the buffer as a float
-                        union
-                        {
-                            float   f;
-                            uint8_t b[4];
-                        } u;
-                        memcpy(u.b, incomingBuffer, 4);
-                        float dataVal = BigEndian(u.f);
-                        set(i, dataVal);
-                        clearIncomingBuffer();
+                        // the datum stays invalid until the content is in
+                        return;
                     }
+                }
+            }
+            else if(incomingBufferSize > 4)
+            {
+                // compute the expected blob size
+                union
+                {
+                    uint32_t i;
+                    uint8_t  b[4];
+                } u;
+                memcpy(u.b, incomingBuffer, 4);
+                uint32_t blobLength = BigEndian(u.i);
+                if(incomingBufferSize == (int)(blobLength + 4))
+                {
+                    set(i, incomingBuffer + 4, blobLength);
+                    clearIncomingBuffer();
+                    decodeState = DATA_PADDING;
+                }
+            }
+            break;
+    }
+    // move on to the next datum once this one is set
+    if(datum->error != INVALID_OSC)
+    {
+        decodeIndex++;
+        skipEmptyData();
+    }
+}
+
+bool OSCMessage::openBlob(uint32_t length, int position)
+{
+    OSCBlobSink sink  = {NULL, NULL, NULL};
+    OSCData    *datum = getOSCData(position);
+    if(blobHandler != NULL
+       && blobHandler(address, position, length, &sink, blobHandlerContext)
+       && (sink.buffer != NULL || sink.chunk != NULL))
+    {
+        datum->~OSCData();
+        new(datum) OSCData(sink.buffer, length, true);
+    }
+    else if(incomingBufferFixed)
+    {
+        // the content can't go through the fixed buffer, it goes straight
+        // into its own allocation, or nowhere if that fails
+        datum->~OSCData();
+        new(datum) OSCData((uint8_t *)NULL, (int)length);
+        sink.buffer = datum->getBlobContent();
+        if(datum->error == ALLOCFAILED)
+        {
+            // the content is still read past, so that the rest of the
+            // message decodes, but the message is in error
+            error = ALLOCFAILED;
+        }
+    }
+    else
+    {
+        return false;
+    }
+    if(datum->error == OSC_OK && length > 0)
+    {
+        // invalid until the content is in
+        datum->error = INVALID_OSC;
+    }
+    blobSink      = sink;
+    blobRemaining = length;
+    blobOffset    = 0;
+    return true;
+}
+
+void OSCMessage::streamBlob(const uint8_t *bytes, int length)
+{
+    if(blobSink.buffer != NULL)
+    {
+        memcpy(blobSink.buffer + blobOffset, bytes, length);
+    }
+    else if(blobSink.chunk != NULL)
+    {
+        blobSink.chunk(bytes, length, blobOffset, blobSink.context);
+    }
+    blobOffset += length;
+    blobRemaining -= length;
+    if(blobRemaining == 0)
+    {
+        // the rest of the message goes through the decoder again
+        OSCData *datum = getOSCData(decodeIndex);
+        if(datum->error == INVALID_OSC)
+        {
+            datum->error = OSC_OK;
+        }
+        decodeIndex++;
+        skipEmptyData();
+        decodeState = DATA_PADDING;
+    }
+}
+
+void OSCMessage::sinkBlob(OSCData *datum, const char *address, int position)
+{
+    uint8_t    *content = datum->data.b;
+    uint32_t    length  = datum->bytes - 4;
+    OSCBlobSink sink    = {NULL, NULL, NULL};
+    datum->~OSCData();
+    if(blobHandler(address, position, length, &sink, blobHandlerContext))
+    {
+        if(sink.buffer != NULL)
+        {
+            memcpy(sink.buffer, content, length);
+            new(datum) OSCData(sink.buffer, length, true);
+            return;
+        }
+        if(sink.chunk != NULL)
+        {
+            sink.chunk(content, length, 0, sink.context);
+            new(datum) OSCData((uint8_t *)NULL, length, true);
+            return;
+        }
+    }
+    new(datum) OSCData(content, length);
+}
+
+// reads a big endian 32-bit word from a possibly unaligned position
+static inline uint32_t readWord(const uint8_t *p)
+{
+    uint32_t u;
+    memcpy(&u, p, 4);
+    return BigEndian(u);
+}
+
+// returns the 4-byte aligned offset following the string starting at offset
+// or 0 if the string is not terminated inside the buffer
+static inline int stringEnd(const uint8_t *bytes, int offset, int length)
+{
+    const uint8_t *end
+        = (const uint8_t *)memchr(bytes + offset, 0, length - offset);
+    if(end == NULL)
+    {
+        return 0;
+    }
+    int next = ((end - bytes) + 4) & ~3;
+    return next <= length ? next : 0;
+}
+
+int OSCMessage::decodeBlock(const uint8_t *bytes, int length)
+{
+    // the address
+    if(length < 8 || bytes[0] != '/')
+    {
+        return 0;
+    }
+    int offset = stringEnd(bytes, 0, length);
+    // the type tags
+    if(offset == 0 || offset >= length || bytes[offset] != ',')
+    {
+        return 0;
+    }
+    const char *types = (const char *)bytes + offset + 1;
+    offset            = stringEnd(bytes, offset, length);
+    if(offset == 0)
+    {
+        return 0;
+    }
+
+    // the data, rolled back if the message turns out to be partial
+    int firstData = dataCount;
+    for(const char *t = types; *t != '\0' && offset > 0; t++)
+    {
+        int remaining = length - offset;
+        switch(*t)
+        {
+            case 'i':
+                if(remaining < 4)
+                {
+                    offset = 0;
                     break;
-                case 'd':
-                    if(incomingBufferSize == 8)
-                    {
-                        // parse the buffer as a double
-                        union
-                        {
-                            double  d;
-                            uint8_t b[8];
-                        } u;
-                        memcpy(u.b, incomingBuffer, 8);
-                        double dataVal = BigEndian(u.d);
-                        set(i, dataVal);
-                        clearIncomingBuffer();
-                    }
+                }
+                add((int32_t)readWord(bytes + offset));
+                offset += 4;
+                break;
+            case 'f':
+                if(remaining < 4)
+                {
+                    offset = 0;
                     break;
-                case 't':
-                    if(incomingBufferSize == 8)
-                    {
-                        // parse the buffer as a timetag
-                        union
-                        {
-                            osctime_t t;
-                            uint8_t   b[8];
-                        } u;
-                        memcpy(u.b, incomingBuffer, 8);
-
-                        u.t.seconds = BigEndian(u.t.seconds);
-                        u.t.fractionofseconds
-                            = BigEndian(u.t.fractionofseconds);
-                        set(i, u.t);
-                        clearIncomingBuffer();
-                    }
+                }
+                {
+                    uint32_t u = readWord(bytes + offset);
+                    float    f;
+                    memcpy(&f, &u, 4);
+                    add(f);
+                }
+                offset += 4;
+                break;
+            case 'd':
+                if(remaining < 8)
+                {
+                    offset = 0;
                     break;
-
-                case 's':
-                    if(incomingByte == 0)
+                }
+                {
+                    uint64_t u = ((uint64_t)readWord(bytes + offset) << 32)
+                                 | readWord(bytes + offset + 4);
+                    double d;
+                    memcpy(&d, &u, 8);
+                    add(d);
+                }
+                offset += 8;
+                break;
+            case 't':
+                if(remaining < 8)
+                {
+                    offset = 0;
+                    break;
+                }
+                {
+                    osctime_t time;
+                    time.seconds           = readWord(bytes + offset);
+                    time.fractionofseconds = readWord(bytes + offset + 4);
+                    add(time);
+                }
+                offset += 8;
+                break;
+            case 's':
+            {
+                int next = stringEnd(bytes, offset, length);
+                if(next > 0)
+                {
+                    add((const char *)bytes + offset);
+                }
+                offset = next;
+            }
+            break;
+            case 'b':
+            {
+                if(remaining < 4)
+                {
+                    offset = 0;
+                    break;
+                }
+                uint32_t blobLength = readWord(bytes + offset);
+                if(blobLength > (uint32_t)(remaining - 4)
+                   || (int)(4 + ((blobLength + 3) & ~3)) > remaining)
+                {
+                    offset = 0;
+                    break;
+                }
+                if(blobHandler != NULL)
+                {
+                    // borrows the packet until the whole message is read
+                    OSCData *d = reserveSlot();
+                    if(d == NULL)
                     {
-                        char *str = (char *)incomingBuffer;
-                        set(i, str);
-                        clearIncomingBuffer();
-                        decodeState = DATA_PADDING;
+                        // still moves past the blob, as add() fails
+                        error = ALLOCFAILED;
                     }
-                    break;
-                case 'b':
-                    if(incomingBufferSize > 4)
+                    else
                     {
-                        // compute the expected blob size
-                        union
-                        {
-                            uint32_t i;
-                            uint8_t  b[4];
-                        } u;
-                        memcpy(u.b, incomingBuffer, 4);
-                        uint32_t blobLength = BigEndian(u.i);
-                        if(incomingBufferSize == (int)(blobLength + 4))
-                        {
-                            set(i, incomingBuffer + 4, blobLength);
-                            clearIncomingBuffer();
-                            decodeState = DATA_PADDING;
-                        }
+                        new(d) OSCData(
+                            (uint8_t *)bytes + offset + 4, blobLength, true);
+                        dataCount++;
                     }
+                }
+                else
+                {
+                    add((uint8_t *)bytes + offset + 4, blobLength);
+                }
+                offset += 4 + ((blobLength + 3) & ~3);
+            }
+            break;
+            case 'T':
+            case 'F':
+            case 'N':
+            case 'I':
+            {
+                // a valid datum which only has a type
+                OSCData *d = reserveSlot();
+                if(d == NULL)
+                {
+                    error = ALLOCFAILED;
                     break;
+                }
+                new(d) OSCData(*t);
+                d->error = OSC_OK;
+                dataCount++;
             }
-            // break out of the for loop once we've selected the first invalid message
             break;
+            // leave the types we can't store to the byte decoder
+            default: offset = 0; break;
         }
     }
+
+    if(offset == 0)
+    {
+        while(dataCount > firstData)
+        {
+            data[--dataCount].~OSCData();
+        }
+        return 0;
+    }
+    // the blobs borrowing the packet go to their sinks, only now that the
+    // message is known to be complete
+    if(blobHandler != NULL)
+    {
+        for(int i = firstData; i < dataCount; i++)
+        {
+            if(data[i].type == 'b' && data[i].borrowed)
+            {
+                sinkBlob(&data[i], (const char *)bytes, i);
+            }
+        }
+    }
+    // the address is only replaced once the whole message was read
+    // an allocation failure while adding the data is kept
+    if(error == INVALID_OSC)
+    {
+        error = OSC_OK;
+    }
+    setAddress((const char *)bytes);
+    decodeIndex = dataCount;
+    return offset;
 }
 
 // does not validate the incoming OSC for correctness
 void OSCMessage::decode(uint8_t incomingByte)
 {
+    // a complete message takes no more bytes until it is emptied
+    if(decodeState == DONE)
+    {
+        return;
+    }
+    if(blobRemaining > 0)
+    {
+        streamBlob(&incomingByte, 1);
+        return;
+    }
+    int stored = incomingBufferSize;
     addToIncomingBuffer(incomingByte);
+    if(incomingBufferSize == stored)
+    {
+        // the message has an error, and the field can't be terminated
+        return;
+    }
     switch(decodeState)
     {
         case STANDBY:
@@ -631,6 +1255,7 @@ void OSCMessage::decode(uint8_t incomingByte)
             {
                 // next state
                 decodeState = TYPES;
+                decodeIndex = dataCount;
                 clearIncomingBuffer();
             }
             break;
@@ -658,6 +1283,7 @@ void OSCMessage::decode(uint8_t incomingByte)
             {
                 clearIncomingBuffer();
                 decodeState = DATA;
+                skipEmptyData();
             }
         }
         break;
@@ -665,30 +1291,25 @@ void OSCMessage::decode(uint8_t incomingByte)
         case DATA_PADDING:
         {
             // get the last valid data
-            for(int i = dataCount - 1; i >= 0; i--)
+            if(decodeIndex > 0)
             {
-                OSCData *datum = getOSCData(i);
-                if(datum->error == OSC_OK)
+                OSCData *datum = getOSCData(decodeIndex - 1);
+                // compute the padding size for the data
+                int dataPad = padSize(datum->bytes);
+                //  if there is no padding required, switch back to DATA, and don't clear the incomingBuffer because it holds next data
+                if(dataPad == 0)
                 {
-                    // compute the padding size for the data
-                    int dataPad = padSize(datum->bytes);
-                    //  if there is no padding required, switch back to DATA, and don't clear the incomingBuffer because it holds next data
-                    if(dataPad == 0)
-                    {
-                        decodeState = DATA;
-                    }
-                    else if(incomingBufferSize == dataPad)
-                    {
-                        clearIncomingBuffer();
-                        decodeState = DATA;
-                    }
-                    break;
+                    decodeState = DATA;
+                }
+                else if(incomingBufferSize == dataPad)
+                {
+                    clearIncomingBuffer();
+                    decodeState = DATA;
                 }
             }
         }
         break;
-        case DONE:
-            break; // TODO: is this correct? - was missing from original code, it did this by default
+        case DONE: break;
     }
 }
 
@@ -704,12 +1325,18 @@ void OSCMessage::addToIncomingBuffer(uint8_t incomingByte)
         incomingBuffer[incomingBufferSize++] = incomingByte;
         incomingBufferFree--;
     }
+    else if(incomingBufferFixed)
+    {
+        error = BUFFER_FULL;
+    }
     else
     {
-        incomingBuffer = (uint8_t *)realloc(
+        // the old buffer is kept if it can't grow
+        uint8_t *mem = (uint8_t *)oscRealloc(
             incomingBuffer, incomingBufferSize + 1 + OSCPREALLOCATEIZE);
-        if(incomingBuffer != NULL)
+        if(mem != NULL)
         {
+            incomingBuffer                       = mem;
             incomingBuffer[incomingBufferSize++] = incomingByte;
             incomingBufferFree                   = OSCPREALLOCATEIZE;
         }
@@ -722,15 +1349,27 @@ void OSCMessage::addToIncomingBuffer(uint8_t incomingByte)
 
 void OSCMessage::clearIncomingBuffer()
 {
-    incomingBuffer = (uint8_t *)realloc(incomingBuffer, OSCPREALLOCATEIZE);
-    if(incomingBuffer != NULL)
+    if(incomingBufferFixed)
+    {
+        incomingBufferFree += incomingBufferSize;
+        incomingBufferSize = 0;
+        return;
+    }
+    uint8_t *mem = (uint8_t *)oscRealloc(incomingBuffer, OSCPREALLOCATEIZE);
+    if(mem != NULL)
     {
+        incomingBuffer     = mem;
         incomingBufferFree = OSCPREALLOCATEIZE;
     }
+    else if(incomingBuffer != NULL)
+    {
+        // the old buffer is kept if it can't shrink
+        incomingBufferFree += incomingBufferSize;
+    }
     else
     {
-        error          = ALLOCFAILED;
-        incomingBuffer = NULL;
+        error              = ALLOCFAILED;
+        incomingBufferFree = 0;
     }
     incomingBufferSize = 0;
 }
@@ -0,0 +1,447 @@
+#include "OSCMessageView.h"
+
+extern osctime_t zerotime;
+
+/*=============================================================================
+    PARSING HELPERS
+ =============================================================================*/
+
+// returns the offset following the padded string which starts at offset
+// or -1 if the string is not terminated inside the packet
+static int skipString(const uint8_t *packet, int offset, int packetLength)
+{
+    const uint8_t *end = (const uint8_t *)memchr(
+        packet + offset, 0, packetLength - offset);
+    if(end == NULL)
+    {
+        return -1;
+    }
+    // the terminator is included in the length, then pad to 4 bytes
+    int next = ((end - packet) + 4) & ~3;
+    return next <= packetLength ? next : -1;
+}
+
+static uint32_t readUint32(const uint8_t *p)
+{
+    uint32_t u;
+    memcpy(&u, p, 4);
+    return BigEndian(u);
+}
+
+/*=============================================================================
+    CONSTRUCTORS
+ =============================================================================*/
+
+OSCMessageView::OSCMessageView()
+{
+    buffer    = NULL;
+    length    = 0;
+    types     = "";
+    dataCount = 0;
+    error     = INVALID_OSC;
+}
+
+OSCMessageView::OSCMessageView(const uint8_t *packet, int packetLength)
+{
+    parse(packet, packetLength);
+}
+
+OSCErrorCode OSCMessageView::parse(const uint8_t *packet, int packetLength)
+{
+    buffer    = packet;
+    length    = 0;
+    types     = "";
+    dataCount = 0;
+    error     = INVALID_OSC;
+
+    // the address
+    if(packetLength < 4 || packet[0] != '/')
+    {
+        return error;
+    }
+    int offset = skipString(packet, 0, packetLength);
+    if(offset < 0)
+    {
+        return error;
+    }
+
+    // the type tags, a message may legally stop right after its address
+    if(offset == packetLength)
+    {
+        length = offset;
+        error  = OSC_OK;
+        return error;
+    }
+    if(packet[offset] != ',')
+    {
+        return error;
+    }
+    const char *typeTags = (const char *)packet + offset + 1;
+    offset               = skipString(packet, offset, packetLength);
+    if(offset < 0)
+    {
+        return error;
+    }
+
+    // the data
+    int count = 0;
+    for(const char *t = typeTags; *t != '\0'; t++)
+    {
+        if(count == OSC_VIEW_MAX_ARGS)
+        {
+            error = BUFFER_FULL;
+            return error;
+        }
+        offsets[count++] = offset;
+        int remaining    = packetLength - offset;
+        switch(*t)
+        {
+            case 'i':
+            case 'f':
+            case 'c':
+            case 'r':
+            case 'm':
+                if(remaining < 4)
+                {
+                    return error;
+                }
+                offset += 4;
+                break;
+            case 'h':
+            case 'd':
+            case 't':
+                if(remaining < 8)
+                {
+                    return error;
+                }
+                offset += 8;
+                break;
+            case 's':
+            case 'S':
+                offset = skipString(packet, offset, packetLength);
+                if(offset < 0)
+                {
+                    return error;
+                }
+                break;
+            case 'b':
+            {
+                if(remaining < 4)
+                {
+                    return error;
+                }
+                uint32_t blobLength = readUint32(packet + offset);
+                // the blob and its padding have to fit in the packet
+                if(blobLength > (uint32_t)(remaining - 4))
+                {
+                    return error;
+                }
+                offset += 4 + ((blobLength + 3) & ~3);
+                if(offset > packetLength)
+                {
+                    return error;
+                }
+            }
+            break;
+            // types without data
+            case 'T':
+            case 'F':
+            case 'N':
+            case 'I':
+            case '[':
+            case ']': break;
+            default: return error;
+        }
+    }
+
+    types     = typeTags;
+    dataCount = count;
+    length    = offset;
+    error     = OSC_OK;
+    return error;
+}
+
+/*=============================================================================
+    GETTING DATA
+ =============================================================================*/
+
+const uint8_t *OSCMessageView::argument(int position, char type)
+{
+    if(position < 0 || position >= dataCount)
+    {
+        error = INDEX_OUT_OF_BOUNDS;
+        return NULL;
+    }
+    if(types[position] != type)
+    {
+        return NULL;
+    }
+    return buffer + offsets[position];
+}
+
+int32_t OSCMessageView::getInt(int position)
+{
+    const uint8_t *p = argument(position, 'i');
+    if(p != NULL)
+        return (int32_t)readUint32(p);
+    else
+        return -1;
+}
+
+osctime_t OSCMessageView::getTime(int position)
+{
+    const uint8_t *p = argument(position, 't');
+    if(p != NULL)
+    {
+        osctime_t t;
+        t.seconds           = readUint32(p);
+        t.fractionofseconds = readUint32(p + 4);
+        return t;
+    }
+    else
+        return zerotime;
+}
+
+float OSCMessageView::getFloat(int position)
+{
+    const uint8_t *p = argument(position, 'f');
+    if(p != NULL)
+    {
+        uint32_t u = readUint32(p);
+        float    f;
+        memcpy(&f, &u, 4);
+        return f;
+    }
+    else
+        return -1;
+}
+
+double OSCMessageView::getDouble(int position)
+{
+    const uint8_t *p = argument(position, 'd');
+    if(p != NULL)
+    {
+        uint64_t u;
+        memcpy(&u, p, 8);
+        u = BigEndian(u);
+        double d;
+        memcpy(&d, &u, 8);
+        return d;
+    }
+    else
+        return -1;
+}
+
+bool OSCMessageView::getBoolean(int position)
+{
+    return testType(position, 'T');
+}
+
+const char *OSCMessageView::getString(int position)
+{
+    return (const char *)argument(position, 's');
+}
+
+int OSCMessageView::getString(int position, char *strBuffer, int bufferSize)
+{
+    const char *s = getString(position);
+    if(s == NULL)
+    {
+        return -1;
+    }
+    int stringBytes = strlen(s) + 1;
+    if(stringBytes > bufferSize)
+    {
+        return -1;
+    }
+    memcpy(strBuffer, s, stringBytes);
+    return stringBytes;
+}
+
+const uint8_t *OSCMessageView::getBlob(int position)
+{
+    const uint8_t *p = argument(position, 'b');
+    if(p != NULL)
+        return p + 4;
+    else
+        return NULL;
+}
+
+int OSCMessageView::getBlob(int position, uint8_t *blobBuffer, int bufferSize)
+{
+    const uint8_t *p = argument(position, 'b');
+    if(p == NULL)
+    {
+        return -1;
+    }
+    int blobLength = readUint32(p);
+    if(blobLength > bufferSize)
+    {
+        return -1;
+    }
+    memcpy(blobBuffer, p + 4, blobLength);
+    return blobLength;
+}
+
+uint32_t OSCMessageView::getBlobLength(int position)
+{
+    const uint8_t *p = argument(position, 'b');
+    if(p != NULL)
+        return readUint32(p);
+    else
+        return -1;
+}
+
+int OSCMessageView::getDataLength(int position)
+{
+    if(position < 0 || position >= dataCount)
+    {
+        error = INDEX_OUT_OF_BOUNDS;
+        return 0;
+    }
+    int end = (position + 1 < dataCount) ? offsets[position + 1] : length;
+    // strings report their length with the terminator but without padding
+    if(types[position] == 's' || types[position] == 'S')
+    {
+        return strlen((const char *)buffer + offsets[position]) + 1;
+    }
+    else if(types[position] == 'b')
+    {
+        return 4 + readUint32(buffer + offsets[position]);
+    }
+    return end - offsets[position];
+}
+
+char OSCMessageView::getType(int position)
+{
+    if(position < 0 || position >= dataCount)
+    {
+        error = INDEX_OUT_OF_BOUNDS;
+        return '\0';
+    }
+    return types[position];
+}
+
+/*=============================================================================
+  TESTING DATA
+=============================================================================*/
+
+bool OSCMessageView::testType(int position, char type)
+{
+    return getType(position) == type;
+}
+
+bool OSCMessageView::isInt(int position)
+{
+    return testType(position, 'i');
+}
+
+bool OSCMessageView::isTime(int position)
+{
+    return testType(position, 't');
+}
+
+bool OSCMessageView::isFloat(int position)
+{
+    return testType(position, 'f');
+}
+
+bool OSCMessageView::isBlob(int position)
+{
+    return testType(position, 'b');
+}
+
+bool OSCMessageView::isChar(int position)
+{
+    return testType(position, 'c');
+}
+
+bool OSCMessageView::isString(int position)
+{
+    return testType(position, 's');
+}
+
+bool OSCMessageView::isDouble(int position)
+{
+    return testType(position, 'd');
+}
+
+bool OSCMessageView::isBoolean(int position)
+{
+    char type = getType(position);
+    return type == 'T' || type == 'F';
+}
+
+/*=============================================================================
+  PATTERN MATCHING
+=============================================================================*/
+
+int OSCMessageView::match(const char *pattern, int addr_offset)
+{
+    if(hasError())
+    {
+        return 0;
+    }
+    const char *address = getAddress();
+    int         pattern_offset;
+    int         address_offset;
+    int         ret = osc_match(
+        address + addr_offset, pattern, &pattern_offset, &address_offset);
+    const char *next = address + addr_offset + pattern_offset;
+    if(ret == 3)
+    {
+        return pattern_offset;
+    }
+    else if(pattern_offset > 0 && *next == '/')
+    {
+        return pattern_offset;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+bool OSCMessageView::fullMatch(const char *pattern, int addr_offset)
+{
+    if(hasError())
+    {
+        return false;
+    }
+    int pattern_offset;
+    int address_offset;
+    int ret = osc_match(
+        getAddress() + addr_offset, pattern, &pattern_offset, &address_offset);
+    return (ret == 3);
+}
+
+bool OSCMessageView::dispatch(const char *pattern,
+                              void (*callback)(OSCMessageView &),
+                              int addr_offset)
+{
+    if(fullMatch(pattern, addr_offset))
+    {
+        callback(*this);
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool OSCMessageView::route(const char *pattern,
+                           void (*callback)(OSCMessageView &, int),
+                           int initial_offset)
+{
+    int match_offset = match(pattern, initial_offset);
+    if(match_offset > 0)
+    {
+        callback(*this, match_offset + initial_offset);
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
@@ -0,0 +1,78 @@
+#include "OSCParameters.h"
+
+#include <math.h>
+
+void OSCParameter::bind(const char *_address,
+                        bool        _integer,
+                        float       _min,
+                        float       _max)
+{
+    address = _address;
+    hash    = oscHash(_address);
+    length  = (int)strlen(_address);
+    integer = _integer;
+    min     = _min;
+    max     = _max;
+    scaling = OSC_SCALE_NONE;
+
+    smoothing        = OSC_SMOOTH_NONE;
+    smoothingSamples = 1;
+    coefficient      = 1;
+    current          = _min;
+    rampTarget       = _min;
+    rampStep         = 0;
+    rampRemaining    = 0;
+
+    value.store(_min, std::memory_order_relaxed);
+    intValue.store((int32_t)_min, std::memory_order_relaxed);
+}
+
+OSCParameter &OSCParameter::smooth(OSCSmoothing _smoothing, int samples)
+{
+    smoothing        = _smoothing;
+    smoothingSamples = samples > 1 ? samples : 1;
+    // reaches 1 - 1/e of a step after that many samples
+    coefficient = 1.0f - expf(-1.0f / smoothingSamples);
+    return *this;
+}
+
+OSCParameter &OSCParameter::scale(OSCScaling _scaling)
+{
+    scaling = _scaling;
+    // exponential scaling can't cross or touch 0
+    if(scaling == OSC_SCALE_EXPONENTIAL && (min <= 0 || max <= 0))
+    {
+        scaling = OSC_SCALE_LINEAR;
+    }
+    return *this;
+}
+
+void OSCParameter::set(float incoming)
+{
+    float scaled;
+    switch(scaling)
+    {
+        case OSC_SCALE_LINEAR: scaled = min + incoming * (max - min); break;
+        case OSC_SCALE_EXPONENTIAL:
+            scaled = min * powf(max / min, incoming);
+            break;
+        default: scaled = incoming; break;
+    }
+    // NaN fails both comparisons, it ends up at min
+    float low  = min < max ? min : max;
+    float high = min < max ? max : min;
+    if(!(scaled >= low))
+    {
+        scaled = low;
+    }
+    else if(scaled > high)
+    {
+        scaled = high;
+    }
+    if(integer)
+    {
+        scaled = roundf(scaled);
+        intValue.store((int32_t)scaled, std::memory_order_relaxed);
+    }
+    value.store(scaled, std::memory_order_relaxed);
+}
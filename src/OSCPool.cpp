@@ -0,0 +1,197 @@
+#include "OSCPool.h"
+
+#ifdef OSC_NO_HEAP
+
+#include <string.h>
+
+#include "OSCCritical.h"
+
+/*=============================================================================
+    POOLS
+ =============================================================================*/
+
+// a free block holds the link to the next free block
+struct FreeBlock
+{
+    FreeBlock *next;
+};
+
+struct Pool
+{
+    uint8_t   *start;
+    uint8_t   *end;
+    FreeBlock *free;
+    size_t     blockSize;
+    size_t     blocks;
+    size_t     used;
+    size_t     highWater;
+    uint32_t   failures;
+};
+
+static const size_t blockSizes[OSC_POOL_CLASSES] = {32, 64, 256, 1024};
+static const size_t blockCounts[OSC_POOL_CLASSES] = {OSC_POOL_BLOCKS_32,
+                                                     OSC_POOL_BLOCKS_64,
+                                                     OSC_POOL_BLOCKS_256,
+                                                     OSC_POOL_BLOCKS_1024};
+
+// the arena holding every pool, smallest blocks first
+alignas(8) static uint8_t arena[32 * OSC_POOL_BLOCKS_32 + 64 * OSC_POOL_BLOCKS_64
+                                + 256 * OSC_POOL_BLOCKS_256
+                                + 1024 * OSC_POOL_BLOCKS_1024]
+    OSC_POOL_MEM_SECTION;
+
+static Pool pools[OSC_POOL_CLASSES];
+static bool poolsReady = false;
+
+// threads every block of every pool onto its free list
+// called inside a critical section
+static void setupPools()
+{
+    uint8_t *mem = arena;
+    for(int i = 0; i < OSC_POOL_CLASSES; i++)
+    {
+        Pool &pool     = pools[i];
+        pool.start     = mem;
+        pool.blockSize = blockSizes[i];
+        pool.blocks    = blockCounts[i];
+        pool.end       = mem + pool.blockSize * pool.blocks;
+        pool.used      = 0;
+        pool.highWater = 0;
+        pool.failures  = 0;
+        pool.free      = NULL;
+        // link the blocks back to front so the first one is handed out first
+        for(size_t b = pool.blocks; b > 0; b--)
+        {
+            FreeBlock *block = (FreeBlock *)(mem + (b - 1) * pool.blockSize);
+            block->next      = pool.free;
+            pool.free        = block;
+        }
+        mem = pool.end;
+    }
+    poolsReady = true;
+}
+
+// returns the pool which owns the block, NULL if none does
+static Pool *findPool(void *ptr)
+{
+    for(int i = 0; i < OSC_POOL_CLASSES; i++)
+    {
+        if((uint8_t *)ptr >= pools[i].start && (uint8_t *)ptr < pools[i].end)
+        {
+            return &pools[i];
+        }
+    }
+    return NULL;
+}
+
+void *oscAlloc(size_t size)
+{
+    void *block = NULL;
+    // the free lists are shared between the main loop and interrupts
+    OSCCriticalSection critical;
+    if(!poolsReady)
+    {
+        setupPools();
+    }
+    // the smallest pool with blocks large enough
+    int i = 0;
+    while(i < OSC_POOL_CLASSES && pools[i].blockSize < size)
+    {
+        i++;
+    }
+    if(i < OSC_POOL_CLASSES)
+    {
+        Pool &pool = pools[i];
+        if(pool.free != NULL)
+        {
+            block     = pool.free;
+            pool.free = pool.free->next;
+            if(++pool.used > pool.highWater)
+            {
+                pool.highWater = pool.used;
+            }
+        }
+        else
+        {
+            pool.failures++;
+        }
+    }
+    return block;
+}
+
+void oscFree(void *ptr)
+{
+    if(ptr == NULL)
+    {
+        return;
+    }
+    OSCCriticalSection critical;
+    Pool              *pool = findPool(ptr);
+    if(pool != NULL)
+    {
+        FreeBlock *block = (FreeBlock *)ptr;
+        block->next      = pool->free;
+        pool->free       = block;
+        pool->used--;
+    }
+}
+
+void *oscRealloc(void *ptr, size_t size)
+{
+    if(ptr == NULL)
+    {
+        return oscAlloc(size);
+    }
+    // blocks have a fixed size, so the block is kept if it is large enough
+    Pool *pool = findPool(ptr);
+    if(pool == NULL)
+    {
+        return NULL;
+    }
+    if(size <= pool->blockSize)
+    {
+        return ptr;
+    }
+    void *mem = oscAlloc(size);
+    if(mem != NULL)
+    {
+        memcpy(mem, ptr, pool->blockSize);
+        oscFree(ptr);
+    }
+    return mem;
+}
+
+/*=============================================================================
+    STATISTICS
+ =============================================================================*/
+
+bool oscPoolGetStats(int pool, OSCPoolStats *stats)
+{
+    if(pool < 0 || pool >= OSC_POOL_CLASSES)
+    {
+        return false;
+    }
+    OSCCriticalSection critical;
+    if(!poolsReady)
+    {
+        setupPools();
+    }
+    stats->blockSize = pools[pool].blockSize;
+    stats->blocks    = pools[pool].blocks;
+    stats->used      = pools[pool].used;
+    stats->highWater = pools[pool].highWater;
+    stats->failures  = pools[pool].failures;
+    return true;
+}
+
+void oscPoolResetStats()
+{
+    OSCCriticalSection critical;
+    for(int i = 0; i < OSC_POOL_CLASSES; i++)
+    {
+        pools[i].highWater = pools[i].used;
+        pools[i].failures  = 0;
+    }
+}
+
+#endif
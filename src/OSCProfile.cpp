@@ -0,0 +1,219 @@
+#include "OSCProfile.h"
+
+#ifdef OSC_PROFILE
+
+#include <string.h>
+
+#include "OSCBundle.h"
+#include "OSCCritical.h"
+#include "OSCHash.h"
+
+#ifdef OSC_HOST
+#include <time.h>
+#endif
+
+/*=============================================================================
+    CLOCK
+ =============================================================================*/
+
+#ifdef OSC_HOST
+uint32_t oscProfileNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec);
+}
+#endif
+
+void oscProfileInit()
+{
+#ifndef OSC_HOST
+    // CoreDebug->DEMCR: enable the trace unit
+    *(volatile uint32_t *)0xE000EDFC |= 1u << 24;
+    // DWT->LAR: the Cortex-M7 locks the DWT until this key is written
+    *(volatile uint32_t *)0xE0001FB0 = 0xC5ACCE55;
+    // DWT->CYCCNT, DWT->CTRL: start counting from zero
+    *(volatile uint32_t *)0xE0001004 = 0;
+    *(volatile uint32_t *)0xE0001000 |= 1;
+#endif
+    oscProfileReset();
+}
+
+/*=============================================================================
+    STATISTICS
+ =============================================================================*/
+
+static OSCProfileStats stages[OSC_STAGE_COUNT];
+
+static const char *stageNames[OSC_STAGE_COUNT]
+    = {"decode", "decodeData", "match", "dispatch", "send"};
+
+struct Route
+{
+    uint32_t        hash;
+    char            address[OSC_PROFILE_NAME_SIZE];
+    OSCProfileStats stats;
+};
+
+static Route routes[OSC_PROFILE_ROUTES];
+static int   routeCount = 0;
+
+void oscProfileReset()
+{
+    OSCCriticalSection critical;
+    for(int i = 0; i < OSC_STAGE_COUNT; i++)
+    {
+        memset(&stages[i], 0, sizeof(OSCProfileStats));
+    }
+    // the routes are kept so that handlers holding their stats stay valid
+    for(int i = 0; i < routeCount; i++)
+    {
+        memset(&routes[i].stats, 0, sizeof(OSCProfileStats));
+    }
+}
+
+void oscProfileRecord(OSCProfileStats *stats, uint32_t elapsed)
+{
+    // an interrupt measuring the same stage must not interleave
+    OSCCriticalSection critical;
+    // min is only valid once there is a measurement
+    if(stats->count++ == 0 || elapsed < stats->min)
+    {
+        stats->min = elapsed;
+    }
+    stats->total += elapsed;
+    if(elapsed > stats->max)
+    {
+        stats->max = elapsed;
+    }
+    // the position of the highest bit set
+    int bucket = elapsed > 0 ? 31 - __builtin_clz(elapsed) : 0;
+    if(bucket >= OSC_PROFILE_BUCKETS)
+    {
+        bucket = OSC_PROFILE_BUCKETS - 1;
+    }
+    stats->histogram[bucket]++;
+}
+
+OSCProfileStats *oscProfileStage(OSCProfileStage stage)
+{
+    return &stages[stage];
+}
+
+const OSCProfileStats *oscProfileGetStage(OSCProfileStage stage)
+{
+    if(stage < 0 || stage >= OSC_STAGE_COUNT)
+    {
+        return NULL;
+    }
+    return oscProfileStage(stage);
+}
+
+const char *oscProfileStageName(OSCProfileStage stage)
+{
+    if(stage < 0 || stage >= OSC_STAGE_COUNT)
+    {
+        return NULL;
+    }
+    return stageNames[stage];
+}
+
+OSCProfileStats *oscProfileRoute(const char *address)
+{
+    uint32_t hash = oscHash(address);
+    for(int i = 0; i < routeCount; i++)
+    {
+        if(routes[i].hash == hash
+           && strncmp(routes[i].address, address, OSC_PROFILE_NAME_SIZE - 1)
+                  == 0)
+        {
+            return &routes[i].stats;
+        }
+    }
+    if(routeCount == OSC_PROFILE_ROUTES)
+    {
+        return NULL;
+    }
+    Route &r = routes[routeCount++];
+    r.hash   = hash;
+    strncpy(r.address, address, OSC_PROFILE_NAME_SIZE - 1);
+    r.address[OSC_PROFILE_NAME_SIZE - 1] = '\0';
+    memset(&r.stats, 0, sizeof(OSCProfileStats));
+    return &r.stats;
+}
+
+int oscProfileRouteCount()
+{
+    return routeCount;
+}
+
+const OSCProfileStats *oscProfileGetRoute(int index, const char **address)
+{
+    if(index < 0 || index >= routeCount)
+    {
+        return NULL;
+    }
+    if(address != NULL)
+    {
+        *address = routes[index].address;
+    }
+    return &routes[index].stats;
+}
+
+/*=============================================================================
+    REPLY
+ =============================================================================*/
+
+// adds the statistics to the message
+static void addStats(OSCMessage &msg, const OSCProfileStats *stats)
+{
+    // a consistent copy, allocating happens outside the critical section
+    OSCProfileStats copy;
+    {
+        OSCCriticalSection critical;
+        copy = *stats;
+    }
+    uint32_t histogram[OSC_PROFILE_BUCKETS];
+    for(int i = 0; i < OSC_PROFILE_BUCKETS; i++)
+    {
+        histogram[i] = BigEndian(copy.histogram[i]);
+    }
+    msg.add((int32_t)copy.count)
+        .add((int32_t)copy.min)
+        .add((int32_t)copy.max)
+        .add((int32_t)oscProfileMean(&copy))
+        .add((uint8_t *)histogram, (int)sizeof(histogram));
+}
+
+bool oscProfileReply(OSCMessage &request, OSCBundle &reply)
+{
+    if(!request.fullMatch(OSC_PROFILE_ADDRESS))
+    {
+        return false;
+    }
+    char address[48];
+    for(int i = 0; i < OSC_STAGE_COUNT; i++)
+    {
+        strcpy(address, OSC_PROFILE_ADDRESS "/");
+        strcat(address, stageNames[i]);
+        OSCMessage *msg = reply.add(address);
+        if(msg == NULL)
+        {
+            return false;
+        }
+        addStats(*msg, oscProfileStage((OSCProfileStage)i));
+    }
+    for(int i = 0; i < routeCount; i++)
+    {
+        OSCMessage *msg = reply.add(OSC_PROFILE_ADDRESS "/route");
+        if(msg == NULL)
+        {
+            return false;
+        }
+        msg->add(routes[i].address);
+        addStats(*msg, &routes[i].stats);
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,481 @@
+#include "OSCRouter.h"
+
+#include <string.h>
+
+/*=============================================================================
+    HELPERS
+ =============================================================================*/
+
+// returns the length of the component starting at address
+static int componentLength(const char *address)
+{
+    const char *end = address;
+    while(*end != '/' && *end != '\0')
+    {
+        end++;
+    }
+    return end - address;
+}
+
+// whether the incoming component uses the pattern syntax
+static bool isPattern(const char *component, int length)
+{
+    while(length--)
+    {
+        char c = *component++;
+        if(c == '*' || c == '?' || c == '[' || c == '{')
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// grows an array so that it has room for one more element
+static bool reserve(void **array, int count, int *capacity, size_t size)
+{
+    if(count < *capacity)
+    {
+        return true;
+    }
+    int   newCapacity = *capacity > 0 ? *capacity * 2 : 8;
+    void *mem         = oscRealloc(*array, size * newCapacity);
+    if(mem == NULL)
+    {
+        return false;
+    }
+    *array    = mem;
+    *capacity = newCapacity;
+    return true;
+}
+
+/*=============================================================================
+    CONSTRUCTOR / DESTRUCTOR
+ =============================================================================*/
+
+OSCRouter::OSCRouter()
+{
+    nodes            = NULL;
+    nodeCount        = 0;
+    nodeCapacity     = 0;
+    literals         = NULL;
+    literalCount     = 0;
+    literalCapacity  = 0;
+    literalIndex     = NULL;
+    literalIndexSize = 0;
+    handlers         = NULL;
+    handlerCount     = 0;
+    handlerCapacity  = 0;
+    names            = NULL;
+    namesSize        = 0;
+    namesCapacity    = 0;
+    empty();
+}
+
+OSCRouter::~OSCRouter()
+{
+    oscFree(nodes);
+    oscFree(literals);
+    oscFree(literalIndex);
+    oscFree(handlers);
+    oscFree(names);
+}
+
+OSCRouter &OSCRouter::empty()
+{
+    error            = OSC_OK;
+    nodeCount        = 0;
+    literalCount     = 0;
+    handlerCount     = 0;
+    treeHandlerCount = 0;
+    namesSize        = 0;
+    for(int i = 0; i < literalIndexSize; i++)
+    {
+        literalIndex[i] = -1;
+    }
+    // the root stands for the empty address
+    if(findOrAddChild(-1, "", 0) != 0)
+    {
+        error = ALLOCFAILED;
+    }
+    return *this;
+}
+
+/*=============================================================================
+    BUILDING THE TREE
+ =============================================================================*/
+
+int OSCRouter::findOrAddChild(int parent, const char *component, int length)
+{
+    uint32_t hash = oscHash(component, length);
+    int      last = -1;
+    if(parent >= 0)
+    {
+        for(int i = nodes[parent].firstChild; i >= 0; i = nodes[i].nextSibling)
+        {
+            Node &n = nodes[i];
+            if(n.hash == hash && n.length == length
+               && memcmp(names + n.name, component, length) == 0)
+            {
+                return i;
+            }
+            last = i;
+        }
+    }
+
+    if(!reserve((void **)&nodes, nodeCount, &nodeCapacity, sizeof(Node)))
+    {
+        return -1;
+    }
+    int name = addName(component, length);
+    if(name < 0)
+    {
+        return -1;
+    }
+
+    int   index   = nodeCount++;
+    Node &n       = nodes[index];
+    n.hash        = hash;
+    n.name        = name;
+    n.length      = length;
+    n.star        = memchr(component, '*', length) != NULL;
+    n.firstChild  = -1;
+    n.nextSibling = -1;
+    n.handler     = -1;
+
+    // children keep the order in which they were added
+    if(last >= 0)
+        nodes[last].nextSibling = index;
+    else if(parent >= 0)
+        nodes[parent].firstChild = index;
+    return index;
+}
+
+int OSCRouter::addName(const char *name, int length)
+{
+    while(namesSize + length + 1 > namesCapacity)
+    {
+        int   newCapacity = namesCapacity > 0 ? namesCapacity * 2 : 64;
+        char *mem         = (char *)oscRealloc(names, newCapacity);
+        if(mem == NULL)
+        {
+            return -1;
+        }
+        names         = mem;
+        namesCapacity = newCapacity;
+    }
+    int offset = namesSize;
+    memcpy(names + offset, name, length);
+    names[offset + length] = '\0';
+    namesSize += length + 1;
+    return offset;
+}
+
+int OSCRouter::findOrAddNode(const char *address)
+{
+    if(nodeCount == 0 || *address != '/')
+    {
+        return -1;
+    }
+    int node = 0;
+    while(*address == '/')
+    {
+        address++;
+        int length = componentLength(address);
+        node       = findOrAddChild(node, address, length);
+        if(node < 0)
+        {
+            return -1;
+        }
+        address += length;
+    }
+    return node;
+}
+
+int OSCRouter::findLiteral(uint32_t hash, const char *address, int length)
+{
+    if(literalIndexSize == 0)
+    {
+        return -1;
+    }
+    int mask = literalIndexSize - 1;
+    for(int i = hash & mask; literalIndex[i] >= 0; i = (i + 1) & mask)
+    {
+        Literal &l = literals[literalIndex[i]];
+        if(l.hash == hash && l.length == length
+           && memcmp(names + l.name, address, length) == 0)
+        {
+            return literalIndex[i];
+        }
+    }
+    return -1;
+}
+
+bool OSCRouter::growLiteralIndex()
+{
+    int  newSize = literalIndexSize > 0 ? literalIndexSize * 2 : 16;
+    int *mem     = (int *)oscRealloc(literalIndex, sizeof(int) * newSize);
+    if(mem == NULL)
+    {
+        return false;
+    }
+    literalIndex     = mem;
+    literalIndexSize = newSize;
+    // put every literal back in its new place
+    for(int i = 0; i < newSize; i++)
+    {
+        literalIndex[i] = -1;
+    }
+    int mask = newSize - 1;
+    for(int l = 0; l < literalCount; l++)
+    {
+        int i = literals[l].hash & mask;
+        while(literalIndex[i] >= 0)
+        {
+            i = (i + 1) & mask;
+        }
+        literalIndex[i] = l;
+    }
+    return true;
+}
+
+int OSCRouter::findOrAddLiteral(const char *address)
+{
+    if(*address != '/')
+    {
+        return -1;
+    }
+    int      length = strlen(address);
+    uint32_t hash   = oscHash(address, length);
+    int      index  = findLiteral(hash, address, length);
+    if(index >= 0)
+    {
+        return index;
+    }
+
+    if((literalCount + 1) * 2 > literalIndexSize && !growLiteralIndex())
+    {
+        return -1;
+    }
+    if(!reserve((void **)&literals,
+                literalCount,
+                &literalCapacity,
+                sizeof(Literal)))
+    {
+        return -1;
+    }
+    int name = addName(address, length);
+    if(name < 0)
+    {
+        return -1;
+    }
+    index      = literalCount++;
+    Literal &l = literals[index];
+    l.hash     = hash;
+    l.name     = name;
+    l.length   = length;
+    l.handler  = -1;
+
+    int mask = literalIndexSize - 1;
+    int i    = hash & mask;
+    while(literalIndex[i] >= 0)
+    {
+        i = (i + 1) & mask;
+    }
+    literalIndex[i] = index;
+    return index;
+}
+
+bool OSCRouter::addHandler(int        *first,
+                           const char *address,
+                           void (*dispatch)(OSCMessage &),
+                           void (*route)(OSCMessage &, int))
+{
+    if(first == NULL
+       || !reserve((void **)&handlers,
+                   handlerCount,
+                   &handlerCapacity,
+                   sizeof(Handler)))
+    {
+        error = ALLOCFAILED;
+        return false;
+    }
+    int      index = handlerCount++;
+    Handler &h     = handlers[index];
+    h.dispatch     = dispatch;
+    h.route        = route;
+    h.next         = -1;
+#ifdef OSC_PROFILE
+    h.profile = oscProfileRoute(address);
+#else
+    (void)address;
+#endif
+    // handlers are called in the order they were added
+    int *link = first;
+    while(*link >= 0)
+    {
+        link = &handlers[*link].next;
+    }
+    *link = index;
+    return true;
+}
+
+bool OSCRouter::addRoute(const char *address, void (*callback)(OSCMessage &))
+{
+    if(strchr(address, '*') == NULL)
+    {
+        int literal = findOrAddLiteral(address);
+        return addHandler(
+            literal >= 0 ? &literals[literal].handler : NULL,
+            address,
+            callback,
+            NULL);
+    }
+    int  node  = findOrAddNode(address);
+    bool added
+        = addHandler(node >= 0 ? &nodes[node].handler : NULL,
+                     address,
+                     callback,
+                     NULL);
+    if(added)
+    {
+        treeHandlerCount++;
+    }
+    return added;
+}
+
+bool OSCRouter::addRoute(const char *address,
+                         void (*callback)(OSCMessage &, int))
+{
+    int  node  = findOrAddNode(address);
+    bool added
+        = addHandler(node >= 0 ? &nodes[node].handler : NULL,
+                     address,
+                     NULL,
+                     callback);
+    if(added)
+    {
+        treeHandlerCount++;
+    }
+    return added;
+}
+
+/*=============================================================================
+    DISPATCHING
+ =============================================================================*/
+
+int OSCRouter::dispatch(OSCMessage &msg)
+{
+    OSC_PROFILE_STAGE(OSC_STAGE_DISPATCH);
+    const char *address = msg.getAddress();
+    if(msg.hasError() || address == NULL || nodeCount == 0)
+    {
+        return 0;
+    }
+    int called = dispatchLiterals(msg);
+    if(treeHandlerCount > 0)
+    {
+        called += walk(0, msg, address, 0);
+    }
+    return called;
+}
+
+int OSCRouter::dispatchLiterals(OSCMessage &msg)
+{
+    int called = 0;
+    if(!msg.isAddressPattern())
+    {
+        // the address was hashed when it was set
+        int index = findLiteral(
+            msg.getAddressHash(), msg.getAddress(), msg.getAddressLength());
+        if(index >= 0)
+        {
+            for(int i = literals[index].handler; i >= 0; i = handlers[i].next)
+            {
+                OSC_PROFILE_ROUTE(handlers[i].profile);
+                handlers[i].dispatch(msg);
+                called++;
+            }
+        }
+        return called;
+    }
+    // patterns are matched against every literal, as msg.dispatch() would
+    for(int l = 0; l < literalCount; l++)
+    {
+        if(msg.fullMatch(names + literals[l].name))
+        {
+            for(int i = literals[l].handler; i >= 0; i = handlers[i].next)
+            {
+                OSC_PROFILE_ROUTE(handlers[i].profile);
+                handlers[i].dispatch(msg);
+                called++;
+            }
+        }
+    }
+    return called;
+}
+
+int OSCRouter::walk(int node, OSCMessage &msg, const char *address, int offset)
+{
+    int  called   = 0;
+    bool complete = address[offset] == '\0';
+
+    // the handlers of this node
+    if(node != 0)
+    {
+        for(int i = nodes[node].handler; i >= 0; i = handlers[i].next)
+        {
+            Handler &h = handlers[i];
+            if(h.route != NULL)
+            {
+                OSC_PROFILE_ROUTE(h.profile);
+                h.route(msg, offset);
+                called++;
+            }
+            else if(complete)
+            {
+                OSC_PROFILE_ROUTE(h.profile);
+                h.dispatch(msg);
+                called++;
+            }
+        }
+    }
+    if(complete)
+    {
+        return called;
+    }
+
+    // the next component of the address
+    const char *component = address + offset + 1;
+    int         length    = componentLength(component);
+    bool        pattern   = isPattern(component, length);
+    uint32_t    hash      = pattern ? 0 : oscHash(component, length);
+    int         next      = offset + 1 + length;
+
+    for(int i = nodes[node].firstChild; i >= 0; i = nodes[i].nextSibling)
+    {
+        Node &n = nodes[i];
+        bool  matched;
+        if(!pattern && !n.star)
+        {
+            // plain components only need to be compared
+            matched = n.hash == hash && n.length == length
+                      && memcmp(names + n.name, component, length) == 0;
+        }
+        else
+        {
+            // the incoming component is the pattern, as in OSCMessage::match()
+            int pattern_offset;
+            int address_offset;
+            int ret = osc_match(
+                component, names + n.name, &pattern_offset, &address_offset);
+            matched = (ret & OSC_MATCH_ADDRESS_COMPLETE)
+                      && pattern_offset == length;
+        }
+        if(matched)
+        {
+            called += walk(i, msg, address, next);
+        }
+    }
+    return called;
+}
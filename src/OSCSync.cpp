@@ -0,0 +1,230 @@
+#include "OSCSync.h"
+
+#include <math.h>
+
+// 32.32 fixed point to seconds
+#define FIXED_SECONDS (1.0 / 4294967296.0)
+
+OSCSync::OSCSync(bool _apply) : apply(_apply)
+{
+    reset();
+}
+
+void OSCSync::reset()
+{
+    count          = 0;
+    next           = 0;
+    estimateTime   = 0;
+    estimateOffset = 0;
+    drift          = 0;
+    error          = 0;
+    confidence     = 0;
+    used           = 0;
+}
+
+OSCMessage &OSCSync::request(OSCMessage &msg)
+{
+    msg.empty();
+    msg.setAddress(OSC_SYNC_ADDRESS);
+    // stamped last, as close to sending as possible
+    msg.add(oscTimeFromFixed(oscTimeMonotonic()));
+    return msg;
+}
+
+OSCMessage &OSCSync::request(OSCMessage &msg, uint64_t now)
+{
+    msg.empty();
+    msg.setAddress(OSC_SYNC_ADDRESS);
+    msg.add(oscTimeFromFixed(now));
+    return msg;
+}
+
+bool OSCSync::receive(OSCMessage &msg)
+{
+    return receive(msg, oscTimeMonotonic());
+}
+
+bool OSCSync::receive(OSCMessage &msg, uint64_t arrival)
+{
+    if(!msg.fullMatch(OSC_SYNC_REPLY_ADDRESS) || msg.size() != 3
+       || !msg.isTime(0) || !msg.isTime(1) || !msg.isTime(2))
+    {
+        return false;
+    }
+    uint64_t t0 = oscTimeToFixed(msg.getTime(0));
+    uint64_t t1 = oscTimeToFixed(msg.getTime(1));
+    uint64_t t2 = oscTimeToFixed(msg.getTime(2));
+    uint64_t t3 = arrival;
+
+    // a reply to a request from before a reset of the clock, or garbage
+    int64_t roundTrip = (int64_t)(t3 - t0);
+    int64_t hostTime  = (int64_t)(t2 - t1);
+    if(roundTrip < 0 || hostTime < 0)
+    {
+        return true;
+    }
+
+    // the differences are taken modulo 2^64, the clocks are far apart but
+    // the two offsets only differ by the delay
+    uint64_t out = t1 - t0;
+    uint64_t in  = t2 - t3;
+
+    Sample &s = samples[next];
+    s.time    = t0 + (uint64_t)(roundTrip / 2);
+    s.offset  = out + (uint64_t)((int64_t)(in - out) / 2);
+    s.delay   = roundTrip > hostTime ? (uint64_t)(roundTrip - hostTime) : 0;
+    next      = (next + 1) % OSC_SYNC_SAMPLES;
+    if(count < OSC_SYNC_SAMPLES)
+    {
+        count++;
+    }
+    estimate();
+    return true;
+}
+
+uint64_t OSCSync::shortestDelay()
+{
+    uint64_t minDelay = samples[0].delay;
+    for(int i = 1; i < count; i++)
+    {
+        if(samples[i].delay < minDelay)
+        {
+            minDelay = samples[i].delay;
+        }
+    }
+    return minDelay;
+}
+
+void OSCSync::estimate()
+{
+    uint64_t minDelay = shortestDelay();
+    // the measurements with at most half again the shortest round trip,
+    // plus 10us for the jitter of a fast link
+    uint64_t maxDelay = minDelay + minDelay / 2 + (1ULL << 32) / 100000;
+
+    // the fit is done relative to the newest measurement used, keeping the
+    // numbers small enough for doubles
+    const Sample *newest = NULL;
+    for(int i = 1; i <= count && newest == NULL; i++)
+    {
+        int           index = (next - i + OSC_SYNC_SAMPLES) % OSC_SYNC_SAMPLES;
+        const Sample &s     = samples[index];
+        if(s.delay <= maxDelay)
+        {
+            newest = &s;
+        }
+    }
+
+    double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+    used = 0;
+    for(int i = 0; i < count; i++)
+    {
+        const Sample &s = samples[i];
+        if(s.delay > maxDelay)
+        {
+            continue;
+        }
+        double x = (int64_t)(s.time - newest->time) * FIXED_SECONDS;
+        double y = (int64_t)(s.offset - newest->offset) * FIXED_SECONDS;
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+        used++;
+    }
+    double meanX    = sumX / used;
+    double meanY    = sumY / used;
+    double variance = sumXX / used - meanX * meanX;
+    // a single measurement, or several at once, don't show the drift
+    if(used > 1 && variance > 0)
+    {
+        drift = (sumXY / used - meanX * meanY) / variance;
+        if(drift > OSC_SYNC_MAX_DRIFT)
+        {
+            drift = OSC_SYNC_MAX_DRIFT;
+        }
+        else if(drift < -OSC_SYNC_MAX_DRIFT)
+        {
+            drift = -OSC_SYNC_MAX_DRIFT;
+        }
+    }
+    else
+    {
+        drift = 0;
+    }
+    double intercept = meanY - drift * meanX;
+
+    double squares = 0;
+    for(int i = 0; i < count; i++)
+    {
+        const Sample &s = samples[i];
+        if(s.delay > maxDelay)
+        {
+            continue;
+        }
+        double x = (int64_t)(s.time - newest->time) * FIXED_SECONDS;
+        double y = (int64_t)(s.offset - newest->offset) * FIXED_SECONDS;
+        double r = y - (intercept + drift * x);
+        squares += r * r;
+    }
+    error = sqrt(squares / used);
+
+    // a measurement can't be trusted closer than half its round trip
+    double halfDelay = minDelay * FIXED_SECONDS / 2;
+    if(halfDelay < 1e-6)
+    {
+        halfDelay = 1e-6;
+    }
+    confidence = (double)used / OSC_SYNC_SAMPLES / (1 + error / halfDelay);
+
+    estimateTime = newest->time;
+    estimateOffset = newest->offset
+                     + (uint64_t)(int64_t)llround(intercept / FIXED_SECONDS);
+    if(apply)
+    {
+        oscTimeSetCorrection(estimateTime,
+                             estimateOffset,
+                             (int32_t)llround(drift / FIXED_SECONDS));
+    }
+}
+
+uint64_t OSCSync::getOffset()
+{
+    return getOffset(oscTimeMonotonic());
+}
+
+uint64_t OSCSync::getOffset(uint64_t at)
+{
+    if(count == 0)
+    {
+        return 0;
+    }
+    double elapsed = (int64_t)(at - estimateTime) * FIXED_SECONDS;
+    return estimateOffset
+           + (uint64_t)(int64_t)llround(elapsed * drift / FIXED_SECONDS);
+}
+
+double OSCSync::getDelay()
+{
+    if(count == 0)
+    {
+        return 0;
+    }
+    return shortestDelay() * FIXED_SECONDS;
+}
+
+bool oscSyncRespond(OSCMessage &request,
+                    OSCMessage &reply,
+                    osctime_t   received,
+                    osctime_t   sent)
+{
+    if(!request.fullMatch(OSC_SYNC_ADDRESS) || request.size() != 1
+       || !request.isTime(0))
+    {
+        return false;
+    }
+    reply.empty();
+    reply.setAddress(OSC_SYNC_REPLY_ADDRESS);
+    reply.add(request.getTime(0)).add(received).add(sent);
+    return true;
+}
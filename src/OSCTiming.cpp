@@ -1,33 +1,243 @@
-#include <stm32h7xx_hal.h>
 #include "OSCTiming.h"
 
-static uint32_t savedcount, savedmicros;
+#include "OSCCritical.h"
+
+/*=============================================================================
+    COUNTER
+ =============================================================================*/
+
+#ifdef OSC_HOST
+
+#include <time.h>
+
+// host builds count the nanoseconds of the monotonic clock
+typedef uint64_t Count;
+
+static inline Count readCounter()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static uint32_t counterFrequency()
+{
+    return 1000000000u;
+}
+
+#else
+
+#include <stm32h7xx_hal.h>
 
 #define TIM_HANDLE TIM2
 
-static void latchOscTime()
+// the 32-bit timer, set up by libDaisy, wraps and the difference of two
+// reads is taken modulo 2^32
+typedef uint32_t Count;
+
+static inline Count readCounter()
 {
-    //  get frequency of timer handle
+    return TIM_HANDLE->CNT;
+}
+
+static uint32_t counterFrequency()
+{
+    // the APB1 timers run at twice the bus clock
     uint32_t clkfreq_hz = HAL_RCC_GetPCLK1Freq() * 2;
-    uint32_t hz         = clkfreq_hz / (TIM_HANDLE->PSC + 1);
+    return clkfreq_hz / (TIM_HANDLE->PSC + 1);
+}
+
+#endif
+
+/*=============================================================================
+    CLOCK
+ =============================================================================*/
+
+// a clock converting counts as count * scale >> shift, scale being
+// 2^(32 + shift) / f rounded, with shift as large as possible so that it
+// fits in 32 bits, the rounding error is then below one part in 2^31
+typedef struct
+{
+    Count    last;      // the counter at the last read
+    uint64_t time;      // 32.32 fixed point
+    uint64_t remainder; // the bits below time, shifted by shift
+    uint32_t scale;
+    int      shift;
+} Clock;
+
+// the time since the first read
+static Clock local;
+// the time of the epoch, running at the local rate corrected by the drift
+// so that reading it takes a single multiply-shift
+static Clock corrected;
 
-    //  get micros from timer count
-    savedmicros = TIM_HANDLE->CNT / (hz / 100000000);
-    //  pretty easy :)
-    savedcount = HAL_GetTick();
+static int32_t drift; // 2^-32 seconds per second
+
+// advances the clock to the counter, called inside a critical section
+static void advance(Clock &clock, Count count)
+{
+    Count    delta = count - clock.last;
+    uint64_t mask  = (1ULL << clock.shift) - 1;
+    clock.last     = count;
+    // 32-bit differences keep the product in 64 bits, only the host's can
+    // be larger
+    while(delta > 0xFFFFFFFF)
+    {
+        uint64_t product = 0xFFFFFFFFULL * clock.scale;
+        clock.time += product >> clock.shift;
+        clock.remainder += product & mask;
+        delta -= 0xFFFFFFFF;
+    }
+    uint64_t product = (uint64_t)(uint32_t)delta * clock.scale;
+    clock.time += product >> clock.shift;
+    // carrying the fraction keeps many short reads as exact as a long one
+    clock.remainder += product & mask;
+    clock.time += clock.remainder >> clock.shift;
+    clock.remainder &= mask;
 }
 
-static osctime_t computeOscTime()
-{ // 4294967296
-    osctime_t t;
-    savedmicros %= 1000000;
-    t.fractionofseconds = (67108864ULL * savedmicros) / 15625; // 2^32/1000000
-    t.seconds           = savedcount / 1000;
-    return t;
+// elapsed * drift / 2^32, split at the seconds so that neither product
+// leaves 64 bits whatever the elapsed time
+static int64_t driftOver(int64_t elapsed, int32_t rate)
+{
+    int64_t seconds  = elapsed >> 32;
+    int64_t fraction = elapsed & 0xFFFFFFFF;
+    return seconds * rate + ((fraction * rate) >> 32);
+}
+
+// makes the corrected clock run at the local rate plus the drift
+// called inside a critical section, after advancing the corrected clock
+static void setRate()
+{
+    int64_t k = (int64_t)local.scale + (((int64_t)local.scale * drift) >> 32);
+    int     s = local.shift;
+    if(k > 0xFFFFFFFF)
+    {
+        k >>= 1;
+        s--;
+    }
+    corrected.scale = (uint32_t)k;
+    corrected.shift = s;
+    // the remainder is in units of the old shift
+    corrected.remainder = 0;
+}
+
+// restarts the corrected clock at the local time plus the offset
+// called inside a critical section, after advancing the local clock
+static void follow(uint64_t offset)
+{
+    corrected.last      = local.last;
+    corrected.time      = local.time + offset;
+    corrected.remainder = 0;
+}
+
+// computes the scale from the timer's frequency
+// called inside a critical section
+static void calibrate()
+{
+    uint32_t f = counterFrequency();
+    int      s = 31 - __builtin_clz(f);
+    uint64_t k = ((1ULL << (32 + s)) + f / 2) / f;
+    // only a power of two frequency rounds to 2^32
+    if(k > 0xFFFFFFFF)
+    {
+        s--;
+        k = ((1ULL << (32 + s)) + f / 2) / f;
+    }
+    Count count = readCounter();
+    if(local.scale == 0)
+    {
+        local.last     = count;
+        corrected.last = count;
+    }
+    else
+    {
+        // the time so far is counted at the old scale
+        advance(local, count);
+        advance(corrected, count);
+    }
+    local.shift = s;
+    local.scale = (uint32_t)k;
+    // the remainder is in units of the old shift
+    local.remainder = 0;
+    setRate();
+}
+
+// calibrates on the first read, called inside a critical section
+static inline void start()
+{
+    if(local.scale == 0)
+    {
+        calibrate();
+    }
+}
+
+void oscTimeInit()
+{
+    OSCCriticalSection critical;
+    calibrate();
+}
+
+uint64_t oscTimeMonotonic()
+{
+    OSCCriticalSection critical;
+    start();
+    advance(local, readCounter());
+    return local.time;
 }
 
 osctime_t oscTime()
 {
-    latchOscTime();
-    return computeOscTime();
-}
\ No newline at end of file
+    OSCCriticalSection critical;
+    start();
+    advance(corrected, readCounter());
+    return oscTimeFromFixed(corrected.time);
+}
+
+void oscTimeSetEpoch(osctime_t now)
+{
+    OSCCriticalSection critical;
+    start();
+    advance(corrected, readCounter());
+    corrected.time      = oscTimeToFixed(now);
+    corrected.remainder = 0;
+    drift               = 0;
+    setRate();
+}
+
+void oscTimeSetOffset(uint64_t offset)
+{
+    OSCCriticalSection critical;
+    start();
+    advance(local, readCounter());
+    follow(offset);
+    drift = 0;
+    setRate();
+}
+
+uint64_t oscTimeGetOffset()
+{
+    OSCCriticalSection critical;
+    start();
+    Count count = readCounter();
+    advance(local, count);
+    advance(corrected, count);
+    return corrected.time - local.time;
+}
+
+void oscTimeSetCorrection(uint64_t reference, uint64_t offset, int32_t _drift)
+{
+    OSCCriticalSection critical;
+    start();
+    advance(local, readCounter());
+    int64_t elapsed = (int64_t)(local.time - reference);
+    follow(offset + (uint64_t)driftOver(elapsed, _drift));
+    drift = _drift;
+    setRate();
+}
+
+int32_t oscTimeGetDrift()
+{
+    OSCCriticalSection critical;
+    return drift;
+}